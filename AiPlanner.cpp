@@ -0,0 +1,76 @@
+#include "AiPlanner.h"
+
+AiPlanner::AiPlanner()
+{
+	targetY = SCREEN_HEIGHT / 2;
+	aimOffset = 0;
+	wait = 0;
+	pending = AI_REPLAN_SURPRISE;
+}
+
+void AiPlanner::replan(bool surprise)
+{
+	if (surprise)
+	{
+		pending = AI_REPLAN_SURPRISE;
+	}
+	else if (pending == AI_REPLAN_NONE)
+	{
+		pending = AI_REPLAN_FOLLOW;
+	}
+}
+
+void AiPlanner::plan(const Ball& ball, double dyScale, const Paddle& paddle, const AiSkill& skill, Rng& rng)
+{
+	if (pending == AI_REPLAN_NONE)
+	{
+		return;
+	}
+
+	// The ball did something the AI didn't see coming: take a moment, and misjudge it a little
+	if (pending == AI_REPLAN_SURPRISE)
+	{
+		wait = skill.reactionTicks;
+		aimOffset = (rng.below(201) - 100) / 100.0 * skill.aimError;
+	}
+
+	// Meet a ball that is coming. For one that is going away, get level with where the other side will
+	// return it from, the mirror image of where this side meets it
+	bool left = paddle.x < SCREEN_WIDTH / 2;
+	double meetX = left ? paddle.x + paddle.width : paddle.x - ball.width;
+	bool coming = left ? ball.xVelocity < 0 : ball.xVelocity > 0;
+	double x = coming ? meetX : SCREEN_WIDTH - meetX - ball.width;
+	targetY = intercept(ball, dyScale, x) + ball.height / 2 + aimOffset;
+	pending = AI_REPLAN_NONE;
+}
+
+double AiPlanner::move(const Paddle& paddle, double speed)
+{
+	// Stop on the target rather than jittering around it
+	double offset = targetY - (paddle.y + paddle.height / 2);
+	double step = fmax(-speed, fmin(speed, offset)) * (wait == 0);
+	wait -= wait > 0;
+	return step;
+}
+
+void AiPlanner::update(const Ball& ball, double dyScale, Paddle& paddle, const AiSkill& skill, Rng& rng)
+{
+	plan(ball, dyScale, paddle, skill, rng);
+	paddle.y = fmax(0, fmin(SCREEN_HEIGHT - paddle.height, paddle.y + move(paddle, paddle.yVelocity)));
+}
+
+double AiPlanner::intercept(const Ball& ball, double dyScale, double x)
+{
+	// Straight line height when the ball gets there, as if there were no walls
+	double ticks = fmax(0, (x - ball.x) / ball.xVelocity);
+	double y = ball.y + ball.yVelocity * dyScale * ticks;
+
+	// Every wall bounce mirrors the path, so fold the straight line back into the court
+	double span = SCREEN_HEIGHT - ball.height;
+	double folded = fmod(y, 2 * span);
+	if (folded < 0)
+	{
+		folded += 2 * span;
+	}
+	return folded > span ? 2 * span - folded : folded;
+}
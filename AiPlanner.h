@@ -0,0 +1,55 @@
+#pragma once
+#include "Tennis.h"
+
+// How good an AI player is. The reaction delay is how many ticks it waits before moving after the
+// ball changes course, and the aim error is the furthest its target can be from where the ball will be
+struct AiSkill
+{
+	int reactionTicks;
+	double aimError;
+};
+
+// Skill player 2 starts with. An aim error past half the paddle plus half the ball can miss outright
+const AiSkill DEFAULT_AI_SKILL = { 12, 24 };
+
+// What the AI has to do before its next move
+enum AiReplan
+{
+	AI_REPLAN_NONE,
+	AI_REPLAN_FOLLOW,
+	AI_REPLAN_SURPRISE
+};
+
+// AiPlanner drives an AI paddle, player 2 in a match. Rather than chasing the ball every tick, it works
+// out once where the ball will reach its side of the court, folding the path off the top and bottom
+// walls, and then moves the paddle toward that point until the ball's course changes again. Each tick
+// is then the same few operations whatever the ball is doing. It plays whichever side its paddle is on
+class AiPlanner
+{
+public:
+	AiPlanner();
+
+	// Asks for a new plan before the next move. A surprise (a paddle hit, a zigzag flip, a reversal, a
+	// bumper) also restarts the reaction delay and picks a new aim error. A wall bounce is already in the
+	// plan, so it only refreshes the target from where the ball really is
+	void replan(bool surprise);
+
+	// Works out the plan if one was asked for. dyScale is how much faster than its velocity the ball
+	// moves vertically (2 during a zigzag)
+	void plan(const Ball& ball, double dyScale, const Paddle& paddle, const AiSkill& skill, Rng& rng);
+
+	// How far the paddle should move this tick at up to speed, once the reaction delay is over
+	double move(const Paddle& paddle, double speed);
+
+	// Plans, then moves the paddle at its own speed
+	void update(const Ball& ball, double dyScale, Paddle& paddle, const AiSkill& skill, Rng& rng);
+
+	// Height the ball will be at when its left edge reaches x, bouncing off the top and bottom walls
+	static double intercept(const Ball& ball, double dyScale, double x);
+
+	// The plan: paddle centre to move to, offset added to it, ticks left before moving, and what to redo
+	double targetY;
+	double aimOffset;
+	int wait;
+	AiReplan pending;
+};
@@ -0,0 +1,110 @@
+#include "AllocTracker.h"
+#include <stdlib.h>
+#include <atomic>
+#include <new>
+
+// Relaxed counters: the totals only have to add up, not order anything
+static std::atomic<long long> allocations(0);
+static std::atomic<long long> bytes(0);
+
+long long allocationCount()
+{
+	return allocations.load(std::memory_order_relaxed);
+}
+
+long long allocatedBytes()
+{
+	return bytes.load(std::memory_order_relaxed);
+}
+
+// The nothrow forms of operator new in the standard library go through these. The aligned forms allocate
+// on their own, so they are replaced below too
+void* operator new(size_t size)
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	bytes.fetch_add((long long)size, std::memory_order_relaxed);
+	void* memory = malloc(size > 0 ? size : 1);
+	if (memory == NULL)
+	{
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+	free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+	free(memory);
+}
+
+// Only there when the compiler has aligned new. The build turns it on for this file even below C++17, so
+// allocations the library makes with it are counted too
+#ifdef __cpp_aligned_new
+void* operator new(size_t size, std::align_val_t alignment)
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	bytes.fetch_add((long long)size, std::memory_order_relaxed);
+#ifdef _WIN32
+	void* memory = _aligned_malloc(size > 0 ? size : 1, (size_t)alignment);
+#else
+	void* memory = NULL;
+	if (posix_memalign(&memory, (size_t)alignment, size > 0 ? size : 1) != 0)
+	{
+		memory = NULL;
+	}
+#endif
+	if (memory == NULL)
+	{
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+	return operator new(size, alignment);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept
+{
+#ifdef _WIN32
+	_aligned_free(memory);
+#else
+	free(memory);
+#endif
+}
+
+void operator delete[](void* memory, std::align_val_t alignment) noexcept
+{
+	operator delete(memory, alignment);
+}
+
+void operator delete(void* memory, size_t, std::align_val_t alignment) noexcept
+{
+	operator delete(memory, alignment);
+}
+
+void operator delete[](void* memory, size_t, std::align_val_t alignment) noexcept
+{
+	operator delete(memory, alignment);
+}
+#endif
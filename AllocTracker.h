@@ -0,0 +1,27 @@
+#pragma once
+
+// Every heap allocation made through operator new is counted, on every thread, so the game loop can check
+// that steady play allocates nothing. An allocation in the middle of a match can stall a frame on the
+// allocator's locks or on the OS handing out pages. AllocTracker.cpp replaces the standard operator new
+// in whatever it is linked into, so only bench and debug builds of the game link it and define
+// ALLOC_TRACKER. Everything else reads the counts as 0
+
+#ifdef ALLOC_TRACKER
+const bool ALLOCATIONS_TRACKED = true;
+
+// Allocations and bytes allocated since startup
+long long allocationCount();
+long long allocatedBytes();
+#else
+const bool ALLOCATIONS_TRACKED = false;
+
+inline long long allocationCount()
+{
+	return 0;
+}
+
+inline long long allocatedBytes()
+{
+	return 0;
+}
+#endif
@@ -0,0 +1,262 @@
+#include "Arena.h"
+#include "Tennis.h"
+#include <cmath>
+#include <stdio.h>
+#include <string.h>
+
+Arena::Arena()
+{
+	mCellSize = ARENA_MAX_CELL;
+	mColumns = 0;
+	mRows = 0;
+	mSweep = 0;
+}
+
+bool Arena::load(const char* path)
+{
+	clear();
+
+	FILE* file = fopen(path, "r");
+	if (file == NULL)
+	{
+		printf("Unable to open arena %s!\n", path);
+		return false;
+	}
+
+	char line[256];
+	int lineNumber = 0;
+	bool success = true;
+	while (success && fgets(line, sizeof(line), file) != NULL)
+	{
+		lineNumber++;
+
+		// Strip comments, then skip blank lines
+		char* comment = strchr(line, '#');
+		if (comment != NULL)
+		{
+			*comment = '\0';
+		}
+		char shape[16];
+		if (sscanf(line, "%15s", shape) != 1)
+		{
+			continue;
+		}
+
+		Bumper bumper;
+		double a, b, c, d;
+		if (strcmp(shape, "rect") == 0 && sscanf(line, "%*s %lf %lf %lf %lf", &a, &b, &c, &d) == 4 && c > 0 && d > 0)
+		{
+			bumper.shape = BUMPER_RECT;
+			bumper.box = { a, b, c, d };
+		}
+		else if (strcmp(shape, "circle") == 0 && sscanf(line, "%*s %lf %lf %lf", &a, &b, &c) == 3 && c > 0)
+		{
+			bumper.shape = BUMPER_CIRCLE;
+			bumper.box = { a - c, b - c, c * 2, c * 2 };
+		}
+		else
+		{
+			printf("Bad bumper on line %d of arena %s!\n", lineNumber, path);
+			success = false;
+			break;
+		}
+		add(bumper);
+	}
+	fclose(file);
+
+	if (!success)
+	{
+		bumpers.clear();
+	}
+	bake();
+	return success;
+}
+
+void Arena::add(const Bumper& bumper)
+{
+	bumpers.push_back(bumper);
+}
+
+void Arena::clear()
+{
+	bumpers.clear();
+	bake();
+}
+
+void Arena::bake()
+{
+	// Cells about twice the size of an average bumper keep a cell's list short without a sweep crossing many cells
+	double extent = 0;
+	for (size_t i = 0; i < bumpers.size(); i++)
+	{
+		extent += fmax(bumpers[i].box.w, bumpers[i].box.h);
+	}
+	mCellSize = bumpers.empty() ? ARENA_MAX_CELL : fmax(ARENA_MIN_CELL, fmin(ARENA_MAX_CELL, 2 * extent / bumpers.size()));
+	mColumns = (int)ceil(SCREEN_WIDTH / mCellSize);
+	mRows = (int)ceil(SCREEN_HEIGHT / mCellSize);
+
+	// Count the bumpers touching each cell, turn the counts into start offsets, then fill the lists
+	mCellStart.assign(mColumns * mRows + 1, 0);
+	for (int pass = 0; pass < 2; pass++)
+	{
+		std::vector<int> filled;
+		if (pass == 1)
+		{
+			for (int i = 1; i <= mColumns * mRows; i++)
+			{
+				mCellStart[i] += mCellStart[i - 1];
+			}
+			mCellBumpers.assign(mCellStart[mColumns * mRows], 0);
+			filled.assign(mCellStart.begin(), mCellStart.end() - 1);
+		}
+
+		for (size_t i = 0; i < bumpers.size(); i++)
+		{
+			const Box& box = bumpers[i].box;
+			for (int r = row(box.y); r <= row(box.y + box.h); r++)
+			{
+				for (int c = column(box.x); c <= column(box.x + box.w); c++)
+				{
+					int cell = r * mColumns + c;
+					if (pass == 0)
+					{
+						mCellStart[cell + 1]++;
+					}
+					else
+					{
+						mCellBumpers[filled[cell]++] = (int)i;
+					}
+				}
+			}
+		}
+	}
+
+	mTestedIn.assign(bumpers.size(), 0);
+	mSweep = 0;
+}
+
+// FNV-1a over the shapes and the bits of the boxes
+uint64_t Arena::hash() const
+{
+	uint64_t hash = 14695981039346656037ULL;
+	for (size_t i = 0; i < bumpers.size(); i++)
+	{
+		uint64_t values[5] = { (uint64_t)bumpers[i].shape };
+		memcpy(&values[1], &bumpers[i].box, sizeof(Box));
+		const unsigned char* bytes = (const unsigned char*)values;
+		for (size_t j = 0; j < sizeof(values); j++)
+		{
+			hash = (hash ^ bytes[j]) * 1099511628211ULL;
+		}
+	}
+	return hash;
+}
+
+int Arena::sweep(const Box& moving, double dx, double dy, SweepHit& hit)
+{
+	if (bumpers.empty())
+	{
+		return -1;
+	}
+
+	// New sweep number. When it wraps, forget every old one
+	mSweep++;
+	if (mSweep == 0)
+	{
+		mTestedIn.assign(bumpers.size(), 0);
+		mSweep = 1;
+	}
+
+	// Walk the columns the path covers. In each, the box is only there for part of the motion, which
+	// decides the rows it reaches in that column
+	int best = -1;
+	int firstColumn = column(fmin(moving.x, moving.x + dx));
+	int lastColumn = column(fmax(moving.x, moving.x + dx) + moving.w);
+	for (int c = firstColumn; c <= lastColumn; c++)
+	{
+		double start = 0;
+		double end = 1;
+		if (dx != 0)
+		{
+			double enter = (c * mCellSize - moving.x - moving.w) / dx;
+			double leave = ((c + 1) * mCellSize - moving.x) / dx;
+			start = fmax(0, fmin(enter, leave));
+			end = fmin(1, fmax(enter, leave));
+			if (start > end)
+			{
+				start = end = fmin(fmax(start, 0), 1);
+			}
+		}
+
+		// Cells at the edges of the grid also hold everything beyond them, so clamped columns take the whole motion
+		if (c == 0 || c == mColumns - 1)
+		{
+			start = 0;
+			end = 1;
+		}
+
+		double top = moving.y + fmin(dy * start, dy * end);
+		double bottom = moving.y + moving.h + fmax(dy * start, dy * end);
+		for (int r = row(top); r <= row(bottom); r++)
+		{
+			int cell = r * mColumns + c;
+			for (int i = mCellStart[cell]; i < mCellStart[cell + 1]; i++)
+			{
+				int bumper = mCellBumpers[i];
+				if (mTestedIn[bumper] != mSweep)
+				{
+					mTestedIn[bumper] = mSweep;
+					test(bumper, moving, dx, dy, best, hit);
+				}
+			}
+		}
+	}
+	return best;
+}
+
+int Arena::sweepAll(const Box& moving, double dx, double dy, SweepHit& hit)
+{
+	int best = -1;
+	for (int i = 0; i < (int)bumpers.size(); i++)
+	{
+		test(i, moving, dx, dy, best, hit);
+	}
+	return best;
+}
+
+void Arena::test(int index, const Box& moving, double dx, double dy, int& best, SweepHit& hit)
+{
+	const Bumper& bumper = bumpers[index];
+	SweepHit candidate;
+	bool touched;
+	if (bumper.shape == BUMPER_CIRCLE)
+	{
+		touched = sweepCircle(moving, dx, dy, bumper.box.x + bumper.box.w / 2, bumper.box.y + bumper.box.h / 2, bumper.box.w / 2, candidate);
+	}
+	else
+	{
+		touched = sweepBox(moving, dx, dy, bumper.box, candidate);
+	}
+
+	// Ignore a face the box is moving away from, so a ball that starts inside a bumper can get out.
+	// Ties go to the lower index so the grid and the full test agree
+	if (touched && dx * candidate.normalX + dy * candidate.normalY < 0
+		&& (best == -1 || candidate.time < hit.time || (candidate.time == hit.time && index < best)))
+	{
+		hit = candidate;
+		best = index;
+	}
+}
+
+// Clamped before converting, so even a runaway ball's position lands in the grid
+int Arena::column(double x)
+{
+	double c = floor(x / mCellSize);
+	return !(c >= 0) ? 0 : (c >= mColumns ? mColumns - 1 : (int)c);
+}
+
+int Arena::row(double y)
+{
+	double r = floor(y / mCellSize);
+	return !(r >= 0) ? 0 : (r >= mRows ? mRows - 1 : (int)r);
+}
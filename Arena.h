@@ -0,0 +1,83 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+#include "Collision.h"
+
+// Bumpers are drawn into the court layer, circles as stacked strips
+class RenderQueue;
+
+enum BumperShape
+{
+	BUMPER_RECT,
+	BUMPER_CIRCLE
+};
+
+// A static obstacle. Circles fill their box, which has to be square
+struct Bumper
+{
+	BumperShape shape;
+	Box box;
+};
+
+// Grid cell sizes the arena picks between. Cells are about twice the size of an average bumper. In a
+// crowded layout the smallest cells still hold a few bumpers each, but smaller ones don't help: the path
+// then overlaps that many bumpers anyway, and the extra cells cost as much as the tests they save
+const double ARENA_MIN_CELL = 8;
+const double ARENA_MAX_CELL = 64;
+
+// Arena is a layout of bumpers for the ball to bounce off. When a layout is loaded it is baked into a
+// uniform grid over the court, each cell listing the bumpers that touch it, and a sweep only tests the
+// bumpers in the cells its path crosses. A sweep's cost grows with how crowded the court is around the
+// path rather than with the number of bumpers, so it stays in microseconds with thousands
+class Arena
+{
+public:
+	Arena();
+
+	// Reads a level file and bakes it. Each line is "rect X Y WIDTH HEIGHT" or "circle CENTRE_X CENTRE_Y RADIUS",
+	// and # starts a comment. Returns false, leaving the arena empty, if the file can't be read or has a bad line
+	bool load(const char* path);
+
+	// Builds a layout in code. Call bake after adding
+	void add(const Bumper& bumper);
+	void clear();
+
+	// Sorts the bumpers into the grid
+	void bake();
+
+	// Sweeps a box against the bumpers it could reach. Returns the index of the earliest bumper it runs
+	// into and fills hit, or -1. Bumpers the box is already leaving are ignored
+	int sweep(const Box& moving, double dx, double dy, SweepHit& hit);
+
+	// The same answer by testing every bumper, for checking and timing the grid
+	int sweepAll(const Box& moving, double dx, double dy, SweepHit& hit);
+
+	// Queues every bumper. Done when the court layer is drawn, not every frame
+	void render(RenderQueue& queue) const;
+
+	// Hash of every bumper's shape and box, to tell whether two layouts are the same
+	uint64_t hash() const;
+
+	std::vector<Bumper> bumpers;
+
+private:
+	// Tests one bumper, keeping it if it is hit before the best so far
+	void test(int index, const Box& moving, double dx, double dy, int& best, SweepHit& hit);
+
+	// Grid cell holding a point, clamped to the grid
+	int column(double x);
+	int row(double y);
+
+	// Cell size and grid dimensions
+	double mCellSize;
+	int mColumns;
+	int mRows;
+
+	// Bumpers per cell: cell i lists mCellBumpers[mCellStart[i]] up to mCellBumpers[mCellStart[i + 1]]
+	std::vector<int> mCellStart;
+	std::vector<int> mCellBumpers;
+
+	// Sweep a bumper was last tested in, so one that spans several cells is only tested once per sweep
+	std::vector<unsigned> mTestedIn;
+	unsigned mSweep;
+};
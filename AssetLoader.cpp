@@ -0,0 +1,129 @@
+#include "AssetLoader.h"
+#include "Trace.h"
+#include <stdio.h>
+
+AssetLoader::AssetLoader(Uint64 startTime)
+{
+	mJobCount = 0;
+	mStartTime = startTime;
+	mWindowTime = 0;
+	mFirstFrameTime = 0;
+	mLoadedTime = 0;
+}
+
+int AssetLoader::start(const char* name, SDL_ThreadFunction job, void* data)
+{
+	if (mJobCount == LOADER_MAX_JOBS)
+	{
+		return -1;
+	}
+
+	Job& slot = mJobs[mJobCount];
+	slot.name = name;
+	slot.function = job;
+	slot.data = data;
+	slot.finished = false;
+	slot.finishTime = 0;
+	slot.succeeded = false;
+	slot.collected = false;
+	slot.thread = SDL_CreateThread(runJob, name, &slot);
+	if (slot.thread == NULL)
+	{
+		printf("Unable to start loader thread %s! SDL Error: %s\n", name, SDL_GetError());
+		return -1;
+	}
+	return mJobCount++;
+}
+
+int AssetLoader::runJob(void* data)
+{
+	Job* job = (Job*)data;
+	TRACE_THREAD(job->name);
+	TRACE_ZONE(job->name);
+	int result = job->function(job->data);
+	job->finishTime = SDL_GetPerformanceCounter();
+	job->finished = true;
+	return result;
+}
+
+int AssetLoader::poll()
+{
+	for (int i = 0; i < mJobCount; i++)
+	{
+		Job& job = mJobs[i];
+		if (!job.collected && job.finished)
+		{
+			int result = 0;
+			SDL_WaitThread(job.thread, &result);
+			job.thread = NULL;
+			job.succeeded = result != 0;
+			job.collected = true;
+			if (isDone())
+			{
+				mLoadedTime = SDL_GetPerformanceCounter();
+			}
+			return i;
+		}
+	}
+	return -1;
+}
+
+bool AssetLoader::succeeded(int job)
+{
+	return job >= 0 && job < mJobCount && mJobs[job].succeeded;
+}
+
+bool AssetLoader::isDone()
+{
+	for (int i = 0; i < mJobCount; i++)
+	{
+		if (!mJobs[i].collected)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void AssetLoader::waitAll()
+{
+	for (int i = 0; i < mJobCount; i++)
+	{
+		if (mJobs[i].thread != NULL)
+		{
+			SDL_WaitThread(mJobs[i].thread, NULL);
+			mJobs[i].thread = NULL;
+			mJobs[i].collected = true;
+		}
+	}
+}
+
+void AssetLoader::windowShown()
+{
+	mWindowTime = SDL_GetPerformanceCounter();
+}
+
+void AssetLoader::firstFrameShown()
+{
+	if (mFirstFrameTime == 0)
+	{
+		mFirstFrameTime = SDL_GetPerformanceCounter();
+	}
+}
+
+void AssetLoader::printTimeline()
+{
+	printf("Startup timeline:\n");
+	printf("  window shown: %.1f ms\n", millisecondsSince(mStartTime, mWindowTime));
+	printf("  first frame: %.1f ms\n", millisecondsSince(mStartTime, mFirstFrameTime));
+	for (int i = 0; i < mJobCount; i++)
+	{
+		printf("  %s loaded: %.1f ms\n", mJobs[i].name, millisecondsSince(mStartTime, mJobs[i].finishTime));
+	}
+	printf("  fully loaded: %.1f ms\n", millisecondsSince(mStartTime, mLoadedTime));
+}
+
+double AssetLoader::millisecondsSince(Uint64 start, Uint64 end)
+{
+	return end > start ? (end - start) * 1000.0 / SDL_GetPerformanceFrequency() : 0;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <SDL.h>
+#include <atomic>
+
+// Most jobs a loader can run at once
+const int LOADER_MAX_JOBS = 4;
+
+// AssetLoader runs loading jobs on worker threads while the main thread keeps drawing frames. A job
+// can read, decode and rasterize, and can open something slow that isn't tied to the main thread, like
+// the audio device, as long as nothing else touches it before poll reports the job finished. It must
+// never use the renderer; that is done by the main thread afterwards. It also keeps the startup
+// timeline: when the window appeared, when the first frame was shown and when every job was done
+class AssetLoader
+{
+public:
+	// startTime is the performance counter when the program started
+	AssetLoader(Uint64 startTime);
+
+	// Starts job on its own thread. The job returns nonzero on success. Returns the job's index, or -1 if it couldn't start
+	int start(const char* name, SDL_ThreadFunction job, void* data);
+
+	// Call once a frame on the main thread. Returns the index of a job that finished since the last call,
+	// whose results can now be used, or -1 if none did
+	int poll();
+
+	// Whether a finished job succeeded
+	bool succeeded(int job);
+
+	// True once every started job has been returned by poll
+	bool isDone();
+
+	// Waits for every job, for shutting down while still loading
+	void waitAll();
+
+	// Startup milestones
+	void windowShown();
+	void firstFrameShown();
+
+	// Prints the startup timeline once everything is loaded
+	void printTimeline();
+
+private:
+	double millisecondsSince(Uint64 start, Uint64 end);
+
+	struct Job
+	{
+		const char* name;
+		SDL_ThreadFunction function;
+		void* data;
+		SDL_Thread* thread;
+		std::atomic<bool> finished;
+		Uint64 finishTime;
+		bool succeeded;
+		bool collected;
+	};
+
+	static int runJob(void* job);
+
+	Job mJobs[LOADER_MAX_JOBS];
+	int mJobCount;
+
+	Uint64 mStartTime;
+	Uint64 mWindowTime;
+	Uint64 mFirstFrameTime;
+	Uint64 mLoadedTime;
+};
@@ -0,0 +1,111 @@
+#include "AssetPack.h"
+#include <stdio.h>
+#include <string.h>
+
+// Little endian u32 at offset
+static uint32_t readValue(const std::vector<Uint8>& data, size_t offset)
+{
+	return data[offset] | (data[offset + 1] << 8) | (data[offset + 2] << 16) | ((uint32_t)data[offset + 3] << 24);
+}
+
+AssetPack::AssetPack()
+{
+}
+
+bool AssetPack::open(const char* fileName)
+{
+	free();
+
+	// Look next to the executable, so the game starts from any working directory
+	char* basePath = SDL_GetBasePath();
+	mBasePath = basePath != NULL ? basePath : "";
+	SDL_free(basePath);
+
+	std::string path = mBasePath + fileName;
+	SDL_RWops* file = SDL_RWFromFile(path.c_str(), "rb");
+	if (file == NULL)
+	{
+		printf("Warning: No asset pack at %s, loading loose files\n", path.c_str());
+		return false;
+	}
+
+	// One read for everything
+	Sint64 size = SDL_RWsize(file);
+	if (size > PACK_HEADER_SIZE)
+	{
+		mData.resize((size_t)size);
+		if (SDL_RWread(file, mData.data(), (size_t)size, 1) != 1)
+		{
+			mData.clear();
+		}
+	}
+	SDL_RWclose(file);
+
+	if (mData.empty() || readValue(mData, 0) != PACK_MAGIC || readValue(mData, 4) != PACK_VERSION)
+	{
+		printf("Warning: %s is not an asset pack this version can read, loading loose files\n", path.c_str());
+		free();
+		return false;
+	}
+
+	// Read the index, checking every asset lies inside the file
+	uint32_t count = readValue(mData, 8);
+	if (PACK_HEADER_SIZE + (size_t)count * PACK_ENTRY_SIZE > mData.size())
+	{
+		printf("Warning: Asset pack %s is damaged, loading loose files\n", path.c_str());
+		free();
+		return false;
+	}
+	for (uint32_t i = 0; i < count; i++)
+	{
+		size_t at = PACK_HEADER_SIZE + i * PACK_ENTRY_SIZE;
+		PackEntry entry;
+		memcpy(entry.name, &mData[at], PACK_NAME_LENGTH);
+		entry.name[PACK_NAME_LENGTH - 1] = '\0';
+		entry.offset = readValue(mData, at + PACK_NAME_LENGTH);
+		entry.size = readValue(mData, at + PACK_NAME_LENGTH + 4);
+		if ((size_t)entry.offset + entry.size > mData.size())
+		{
+			printf("Warning: Asset pack %s is damaged, loading loose files\n", path.c_str());
+			free();
+			return false;
+		}
+		mEntries.push_back(entry);
+	}
+
+	return true;
+}
+
+SDL_RWops* AssetPack::openAsset(const char* name)
+{
+	for (size_t i = 0; i < mEntries.size(); i++)
+	{
+		if (strcmp(mEntries[i].name, name) == 0)
+		{
+			return SDL_RWFromConstMem(&mData[mEntries[i].offset], (int)mEntries[i].size);
+		}
+	}
+
+	// Not packed, so try the loose file next to the executable, then in the working directory
+	if (!mEntries.empty())
+	{
+		printf("Warning: %s is not in the asset pack\n", name);
+	}
+	SDL_RWops* file = SDL_RWFromFile((mBasePath + name).c_str(), "rb");
+	if (file == NULL)
+	{
+		file = SDL_RWFromFile(name, "rb");
+	}
+	return file;
+}
+
+int AssetPack::getCount()
+{
+	return (int)mEntries.size();
+}
+
+void AssetPack::free()
+{
+	mData.clear();
+	mEntries.clear();
+}
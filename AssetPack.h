@@ -0,0 +1,38 @@
+#pragma once
+#include <SDL.h>
+#include <string>
+#include <vector>
+#include "PackFormat.h"
+
+// Pack the game looks for next to its executable
+const char* const ASSET_PACK_FILE = "assets.pak";
+
+// AssetPack reads every asset in one file read at startup and hands them out as read-only memory streams,
+// so fonts and sounds are parsed straight from the pack with no further opens or copies. It finds the pack
+// next to the executable rather than in the working directory. Without a pack, assets are read from the
+// loose files next to the executable, or failing that in the working directory
+class AssetPack
+{
+public:
+	AssetPack();
+
+	// Reads the pack. Returns false if there is no usable pack, in which case loose files are used
+	bool open(const char* fileName);
+
+	// Opens an asset for reading. The stream reads the pack's memory, which stays valid until free().
+	// Returns NULL if the asset can't be found
+	SDL_RWops* openAsset(const char* name);
+
+	// Number of assets in the pack, 0 when using loose files
+	int getCount();
+
+	void free();
+
+private:
+	// Directory the executable is in, with a trailing separator
+	std::string mBasePath;
+
+	// The whole pack file, and its index
+	std::vector<Uint8> mData;
+	std::vector<PackEntry> mEntries;
+};
@@ -0,0 +1,158 @@
+#include "AudioDevice.h"
+#include <SDL_mixer.h>
+#include <stdio.h>
+
+AudioDevice::AudioDevice()
+	: mUnderruns(0), mStartTime(0), mLatencyTotalUs(0), mLatencyMaxUs(0), mLatencyCount(0)
+{
+	mFrequency = 0;
+	mFormat = 0;
+	mChannels = 0;
+	mBufferFrames = 0;
+	mFrameBytes = 0;
+	mOpen = false;
+	mUnderrunsAtSize = 0;
+	mUnderrunsTotal = 0;
+	mMixStart = 0;
+	mFramesMixed = 0;
+}
+
+bool AudioDevice::open(int bufferFrames)
+{
+	if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, bufferFrames) < 0)
+	{
+		printf("SDL_mixer could not initialize! SDL_mixer Error: %s\n", Mix_GetError());
+		return false;
+	}
+
+	// The device may not give us exactly what we asked for
+	Mix_QuerySpec(&mFrequency, &mFormat, &mChannels);
+	mBufferFrames = bufferFrames;
+	mFrameBytes = mChannels * SDL_AUDIO_BITSIZE(mFormat) / 8;
+	mOpen = true;
+	mUnderrunsAtSize = 0;
+	mUnderruns = 0;
+	mStartTime = 0;
+	mMixStart = 0;
+	mFramesMixed = 0;
+	Mix_SetPostMix(postMix, this);
+	return true;
+}
+
+void AudioDevice::close()
+{
+	if (mOpen)
+	{
+		Mix_SetPostMix(NULL, NULL);
+		Mix_CloseAudio();
+		mOpen = false;
+	}
+}
+
+bool AudioDevice::update()
+{
+	int underruns = mUnderruns.exchange(0);
+	mUnderrunsAtSize += underruns;
+	mUnderrunsTotal += underruns;
+
+	if (!mOpen || mUnderrunsAtSize < AUDIO_FALLBACK_UNDERRUNS || mBufferFrames >= AUDIO_SAFE_FRAMES)
+	{
+		return false;
+	}
+
+	// Keeps falling behind, so trade some latency for a buffer the system can keep up with
+	int bufferFrames = mBufferFrames * 2;
+	printf("Audio underran %d times with a %d frame buffer, switching to %d frames\n", mUnderrunsAtSize, mBufferFrames, bufferFrames);
+	int previousFrames = mBufferFrames;
+	close();
+	if (!open(bufferFrames))
+	{
+		// Better to keep underrunning than to lose audio for the rest of the session
+		printf("Could not open audio with %d frames, going back to %d frames\n", bufferFrames, previousFrames);
+		if (!open(previousFrames))
+		{
+			printf("Could not reopen audio, sound is off\n");
+			return false;
+		}
+	}
+	return true;
+}
+
+void AudioDevice::soundStarted()
+{
+	// Follow one sound at a time. The next mix picks it up
+	Uint64 expected = 0;
+	mStartTime.compare_exchange_strong(expected, SDL_GetPerformanceCounter());
+}
+
+int AudioDevice::getFrequency()
+{
+	return mFrequency;
+}
+
+Uint16 AudioDevice::getFormat()
+{
+	return mFormat;
+}
+
+int AudioDevice::getChannels()
+{
+	return mChannels;
+}
+
+int AudioDevice::getBufferFrames()
+{
+	return mBufferFrames;
+}
+
+void AudioDevice::printReport()
+{
+	int count = mLatencyCount;
+	printf("Audio: %d frame buffer, %d underruns\n", mBufferFrames, mUnderrunsTotal + mUnderruns.load());
+	printf("  sound start to output: %.2f / %.2f ms (average / worst over %d sounds)\n",
+		count > 0 ? mLatencyTotalUs / 1000.0 / count : 0, mLatencyMaxUs / 1000.0, count);
+}
+
+void AudioDevice::postMix(void* userdata, Uint8*, int length)
+{
+	((AudioDevice*)userdata)->mixed(length);
+}
+
+void AudioDevice::mixed(int length)
+{
+	Uint64 now = SDL_GetPerformanceCounter();
+	Uint64 frequency = SDL_GetPerformanceFrequency();
+	int frames = length / mFrameBytes;
+
+	// The device has been consuming audio in real time since counting started. If it has used a whole
+	// buffer more than was mixed, it ran dry. Start counting again from here
+	if (mMixStart == 0)
+	{
+		mMixStart = now;
+	}
+	else
+	{
+		double played = (double)(now - mMixStart) / frequency * mFrequency;
+		if (played - mFramesMixed > mBufferFrames)
+		{
+			mUnderruns++;
+			mMixStart = now;
+			mFramesMixed = 0;
+		}
+	}
+	mFramesMixed += frames;
+
+	// A sound started since the last mix is in this buffer. It is heard once the buffer ahead of it has played
+	Uint64 start = mStartTime.exchange(0);
+	if (start != 0)
+	{
+		Uint64 waitedUs = (now - start) * 1000000 / frequency;
+		int latencyUs = (int)(waitedUs + (Uint64)frames * 1000000 / mFrequency);
+		mLatencyTotalUs += latencyUs;
+		mLatencyCount++;
+		if (latencyUs > mLatencyMaxUs)
+		{
+			mLatencyMaxUs = latencyUs;
+		}
+	}
+}
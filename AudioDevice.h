@@ -0,0 +1,69 @@
+#pragma once
+#include <SDL.h>
+#include <atomic>
+
+// Default buffer size in frames. 512 frames at 44.1kHz is about 12ms, where the old 2048 was about 46ms
+const int AUDIO_LOW_LATENCY_FRAMES = 512;
+
+// Largest buffer the fallback grows to, the size the game always used before
+const int AUDIO_SAFE_FRAMES = 2048;
+
+// Underruns tolerated at one buffer size before it is doubled
+const int AUDIO_FALLBACK_UNDERRUNS = 3;
+
+// AudioDevice opens the mixer with a small buffer and watches the mix callback for underruns: when
+// the device has played more audio than has been mixed by a whole buffer, the mixer fell behind and the
+// player heard a gap. If it keeps happening the device is reopened with twice the buffer. It also
+// measures how long a sound takes from being started to reaching the speakers
+class AudioDevice
+{
+public:
+	AudioDevice();
+
+	// Opens the mixer with the requested buffer size in frames. Returns false if no audio device could be opened
+	bool open(int bufferFrames);
+	void close();
+
+	// Call once a frame. Reopens the device with a bigger buffer after repeated underruns, or with the old
+	// one if the bigger buffer won't open, and returns true if it reopened, since the sound bank then has
+	// to match the new device format
+	bool update();
+
+	// Call right after starting a sound, to time it through the mixer
+	void soundStarted();
+
+	// The format the mixer actually got, which sounds have to be converted to
+	int getFrequency();
+	Uint16 getFormat();
+	int getChannels();
+	int getBufferFrames();
+
+	// Prints the buffer size, underruns and measured output latency
+	void printReport();
+
+private:
+	static void postMix(void* userdata, Uint8* stream, int length);
+	void mixed(int length);
+
+	int mFrequency;
+	Uint16 mFormat;
+	int mChannels;
+	int mBufferFrames;
+	int mFrameBytes;
+	bool mOpen;
+
+	// Underruns at this buffer size, and since the game started
+	int mUnderrunsAtSize;
+	int mUnderrunsTotal;
+
+	// Written by the audio thread
+	std::atomic<int> mUnderruns;
+	std::atomic<Uint64> mStartTime;
+	std::atomic<long long> mLatencyTotalUs;
+	std::atomic<int> mLatencyMaxUs;
+	std::atomic<int> mLatencyCount;
+
+	// Audio thread only: when frames started being counted and how many have been mixed since
+	Uint64 mMixStart;
+	long long mFramesMixed;
+};
@@ -0,0 +1,418 @@
+#include "BallPool.h"
+#include "Tennis.h"
+#include <string.h>
+
+// SSE2 is always there on x86-64. AVX2 is compiled in for those CPUs too and picked at runtime
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+#define BALLPOOL_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define BALLPOOL_AVX2_TARGET
+#else
+#define BALLPOOL_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+// Everything a kernel needs for one tick. Edges are worked out once so every kernel does the same float math
+struct StepParams
+{
+	float* x;
+	float* y;
+	float* xVelocity;
+	float* yVelocity;
+	int count;
+
+	// Ball size, how far down a ball can go, and twice that for reflecting off the bottom
+	float size;
+	float maxY;
+	float maxY2;
+
+	// A ball past these has left the court
+	float courtLeft;
+	float courtRight;
+
+	// Paddle edges. A ball that hits player 1 stops at its front, one that hits player 2 at p2Stop
+	float p1Left, p1Right, p1Top, p1Bottom;
+	float p2Left, p2Right, p2Top, p2Bottom;
+	float p2Stop;
+
+	// Balls that left the court, in index order
+	int* leftCourt;
+	int leftCount;
+};
+
+// One ball, used by the scalar kernel and for the leftovers of the SIMD ones
+static inline int stepBall(StepParams& p, int i)
+{
+	float x = p.x[i] + p.xVelocity[i];
+	float y = p.y[i] + p.yVelocity[i];
+	float xVelocity = p.xVelocity[i];
+	float yVelocity = p.yVelocity[i];
+
+	// Top and bottom walls reflect the ball back into the court
+	if (y < 0)
+	{
+		y = -y;
+		yVelocity = -yVelocity;
+	}
+	else if (y > p.maxY)
+	{
+		y = p.maxY2 - y;
+		yVelocity = -yVelocity;
+	}
+
+	// Paddles only turn around a ball heading toward them
+	int hits = 0;
+	bool overlapY1 = y < p.p1Bottom && y + p.size > p.p1Top;
+	bool overlapY2 = y < p.p2Bottom && y + p.size > p.p2Top;
+	if (x < p.p1Right && x + p.size > p.p1Left && overlapY1 && xVelocity < 0)
+	{
+		x = p.p1Right;
+		xVelocity = -xVelocity;
+		hits++;
+	}
+	else if (x < p.p2Right && x + p.size > p.p2Left && overlapY2 && xVelocity > 0)
+	{
+		x = p.p2Stop;
+		xVelocity = -xVelocity;
+		hits++;
+	}
+
+	p.x[i] = x;
+	p.y[i] = y;
+	p.xVelocity[i] = xVelocity;
+	p.yVelocity[i] = yVelocity;
+
+	if (x < p.courtLeft || x > p.courtRight)
+	{
+		p.leftCourt[p.leftCount++] = i;
+	}
+	return hits;
+}
+
+static int stepScalar(StepParams& p, int first)
+{
+	int hits = 0;
+	for (int i = first; i < p.count; i++)
+	{
+		hits += stepBall(p, i);
+	}
+	return hits;
+}
+
+// Lanes set in a compare mask
+static inline int countLanes(int mask)
+{
+	int count = 0;
+	for (; mask != 0; mask &= mask - 1)
+	{
+		count++;
+	}
+	return count;
+}
+
+#ifdef BALLPOOL_X86
+
+// SSE2 has no blend, so pick lanes with and/or
+static inline __m128 select4(__m128 mask, __m128 ifSet, __m128 ifClear)
+{
+	return _mm_or_ps(_mm_and_ps(mask, ifSet), _mm_andnot_ps(mask, ifClear));
+}
+
+static int stepSse(StepParams& p)
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 sign = _mm_set1_ps(-0.0f);
+	const __m128 size = _mm_set1_ps(p.size);
+	const __m128 maxY = _mm_set1_ps(p.maxY);
+	const __m128 maxY2 = _mm_set1_ps(p.maxY2);
+	const __m128 courtLeft = _mm_set1_ps(p.courtLeft);
+	const __m128 courtRight = _mm_set1_ps(p.courtRight);
+	const __m128 p1Left = _mm_set1_ps(p.p1Left), p1Right = _mm_set1_ps(p.p1Right);
+	const __m128 p1Top = _mm_set1_ps(p.p1Top), p1Bottom = _mm_set1_ps(p.p1Bottom);
+	const __m128 p2Left = _mm_set1_ps(p.p2Left), p2Right = _mm_set1_ps(p.p2Right);
+	const __m128 p2Top = _mm_set1_ps(p.p2Top), p2Bottom = _mm_set1_ps(p.p2Bottom);
+	const __m128 p2Stop = _mm_set1_ps(p.p2Stop);
+
+	int hits = 0;
+	int i = 0;
+	for (; i + 4 <= p.count; i += 4)
+	{
+		__m128 xVelocity = _mm_loadu_ps(p.xVelocity + i);
+		__m128 yVelocity = _mm_loadu_ps(p.yVelocity + i);
+		__m128 x = _mm_add_ps(_mm_loadu_ps(p.x + i), xVelocity);
+		__m128 y = _mm_add_ps(_mm_loadu_ps(p.y + i), yVelocity);
+
+		// Walls
+		__m128 top = _mm_cmplt_ps(y, zero);
+		__m128 bottom = _mm_cmpgt_ps(y, maxY);
+		y = select4(top, _mm_xor_ps(y, sign), select4(bottom, _mm_sub_ps(maxY2, y), y));
+		yVelocity = select4(_mm_or_ps(top, bottom), _mm_xor_ps(yVelocity, sign), yVelocity);
+
+		// Paddles
+		__m128 right = _mm_add_ps(x, size);
+		__m128 lower = _mm_add_ps(y, size);
+		__m128 hit1 = _mm_and_ps(_mm_and_ps(_mm_cmplt_ps(x, p1Right), _mm_cmpgt_ps(right, p1Left)),
+			_mm_and_ps(_mm_and_ps(_mm_cmplt_ps(y, p1Bottom), _mm_cmpgt_ps(lower, p1Top)), _mm_cmplt_ps(xVelocity, zero)));
+		__m128 hit2 = _mm_and_ps(_mm_and_ps(_mm_cmplt_ps(x, p2Right), _mm_cmpgt_ps(right, p2Left)),
+			_mm_and_ps(_mm_and_ps(_mm_cmplt_ps(y, p2Bottom), _mm_cmpgt_ps(lower, p2Top)), _mm_cmpgt_ps(xVelocity, zero)));
+		hit2 = _mm_andnot_ps(hit1, hit2);
+		__m128 hit = _mm_or_ps(hit1, hit2);
+		x = select4(hit1, p1Right, select4(hit2, p2Stop, x));
+		xVelocity = select4(hit, _mm_xor_ps(xVelocity, sign), xVelocity);
+		hits += countLanes(_mm_movemask_ps(hit));
+
+		_mm_storeu_ps(p.x + i, x);
+		_mm_storeu_ps(p.y + i, y);
+		_mm_storeu_ps(p.xVelocity + i, xVelocity);
+		_mm_storeu_ps(p.yVelocity + i, yVelocity);
+
+		// Out of the court is rare, so only look at the lanes when there is one
+		int out = _mm_movemask_ps(_mm_or_ps(_mm_cmplt_ps(x, courtLeft), _mm_cmpgt_ps(x, courtRight)));
+		for (int lane = 0; out != 0; lane++, out >>= 1)
+		{
+			if (out & 1)
+			{
+				p.leftCourt[p.leftCount++] = i + lane;
+			}
+		}
+	}
+
+	return hits + stepScalar(p, i);
+}
+
+BALLPOOL_AVX2_TARGET static int stepAvx2(StepParams& p)
+{
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 sign = _mm256_set1_ps(-0.0f);
+	const __m256 size = _mm256_set1_ps(p.size);
+	const __m256 maxY = _mm256_set1_ps(p.maxY);
+	const __m256 maxY2 = _mm256_set1_ps(p.maxY2);
+	const __m256 courtLeft = _mm256_set1_ps(p.courtLeft);
+	const __m256 courtRight = _mm256_set1_ps(p.courtRight);
+	const __m256 p1Left = _mm256_set1_ps(p.p1Left), p1Right = _mm256_set1_ps(p.p1Right);
+	const __m256 p1Top = _mm256_set1_ps(p.p1Top), p1Bottom = _mm256_set1_ps(p.p1Bottom);
+	const __m256 p2Left = _mm256_set1_ps(p.p2Left), p2Right = _mm256_set1_ps(p.p2Right);
+	const __m256 p2Top = _mm256_set1_ps(p.p2Top), p2Bottom = _mm256_set1_ps(p.p2Bottom);
+	const __m256 p2Stop = _mm256_set1_ps(p.p2Stop);
+
+	int hits = 0;
+	int i = 0;
+	for (; i + 8 <= p.count; i += 8)
+	{
+		__m256 xVelocity = _mm256_loadu_ps(p.xVelocity + i);
+		__m256 yVelocity = _mm256_loadu_ps(p.yVelocity + i);
+		__m256 x = _mm256_add_ps(_mm256_loadu_ps(p.x + i), xVelocity);
+		__m256 y = _mm256_add_ps(_mm256_loadu_ps(p.y + i), yVelocity);
+
+		// Walls
+		__m256 top = _mm256_cmp_ps(y, zero, _CMP_LT_OQ);
+		__m256 bottom = _mm256_cmp_ps(y, maxY, _CMP_GT_OQ);
+		y = _mm256_blendv_ps(_mm256_blendv_ps(y, _mm256_sub_ps(maxY2, y), bottom), _mm256_xor_ps(y, sign), top);
+		yVelocity = _mm256_blendv_ps(yVelocity, _mm256_xor_ps(yVelocity, sign), _mm256_or_ps(top, bottom));
+
+		// Paddles
+		__m256 right = _mm256_add_ps(x, size);
+		__m256 lower = _mm256_add_ps(y, size);
+		__m256 hit1 = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(x, p1Right, _CMP_LT_OQ), _mm256_cmp_ps(right, p1Left, _CMP_GT_OQ)),
+			_mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(y, p1Bottom, _CMP_LT_OQ), _mm256_cmp_ps(lower, p1Top, _CMP_GT_OQ)),
+				_mm256_cmp_ps(xVelocity, zero, _CMP_LT_OQ)));
+		__m256 hit2 = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(x, p2Right, _CMP_LT_OQ), _mm256_cmp_ps(right, p2Left, _CMP_GT_OQ)),
+			_mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(y, p2Bottom, _CMP_LT_OQ), _mm256_cmp_ps(lower, p2Top, _CMP_GT_OQ)),
+				_mm256_cmp_ps(xVelocity, zero, _CMP_GT_OQ)));
+		hit2 = _mm256_andnot_ps(hit1, hit2);
+		__m256 hit = _mm256_or_ps(hit1, hit2);
+		x = _mm256_blendv_ps(_mm256_blendv_ps(x, p2Stop, hit2), p1Right, hit1);
+		xVelocity = _mm256_blendv_ps(xVelocity, _mm256_xor_ps(xVelocity, sign), hit);
+		hits += countLanes(_mm256_movemask_ps(hit));
+
+		_mm256_storeu_ps(p.x + i, x);
+		_mm256_storeu_ps(p.y + i, y);
+		_mm256_storeu_ps(p.xVelocity + i, xVelocity);
+		_mm256_storeu_ps(p.yVelocity + i, yVelocity);
+
+		int out = _mm256_movemask_ps(_mm256_or_ps(_mm256_cmp_ps(x, courtLeft, _CMP_LT_OQ), _mm256_cmp_ps(x, courtRight, _CMP_GT_OQ)));
+		for (int lane = 0; out != 0; lane++, out >>= 1)
+		{
+			if (out & 1)
+			{
+				p.leftCourt[p.leftCount++] = i + lane;
+			}
+		}
+	}
+
+	return hits + stepScalar(p, i);
+}
+
+// AVX2 needs the CPU to have it and the OS to save the wider registers
+static bool cpuHasAvx2()
+{
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	bool osSaves = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+	__cpuidex(info, 7, 0);
+	return osSaves && (info[1] & (1 << 5)) != 0;
+#else
+	return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+#endif
+
+BallPool::BallPool(uint64_t seed)
+	: mRng(seed, 1)
+{
+	mKernel = bestKernel();
+	mCount = 0;
+}
+
+void BallPool::spawn(int count)
+{
+	mCount = count > 0 ? count : 0;
+	std::vector<float>* fields[] = { &x, &y, &xVelocity, &yVelocity, &prevX, &prevY, &mRenderX, &mRenderY };
+	for (std::vector<float>* field : fields)
+	{
+		field->assign(mCount, 0);
+	}
+	mLeftCourt.assign(mCount, 0);
+
+	for (int i = 0; i < mCount; i++)
+	{
+		serve(i);
+	}
+}
+
+int BallPool::getCount() const
+{
+	return mCount;
+}
+
+void BallPool::storePrevious()
+{
+	if (mCount > 0)
+	{
+		memcpy(prevX.data(), x.data(), mCount * sizeof(float));
+		memcpy(prevY.data(), y.data(), mCount * sizeof(float));
+	}
+}
+
+int BallPool::step(const Box& paddle1, const Box& paddle2)
+{
+	if (mCount == 0)
+	{
+		return 0;
+	}
+
+	StepParams params;
+	params.x = x.data();
+	params.y = y.data();
+	params.xVelocity = xVelocity.data();
+	params.yVelocity = yVelocity.data();
+	params.count = mCount;
+	params.size = CHAOS_BALL_SIZE;
+	params.maxY = SCREEN_HEIGHT - CHAOS_BALL_SIZE;
+	params.maxY2 = params.maxY * 2;
+	params.courtLeft = -CHAOS_BALL_SIZE;
+	params.courtRight = SCREEN_WIDTH;
+	params.p1Left = (float)paddle1.x;
+	params.p1Right = (float)(paddle1.x + paddle1.w);
+	params.p1Top = (float)paddle1.y;
+	params.p1Bottom = (float)(paddle1.y + paddle1.h);
+	params.p2Left = (float)paddle2.x;
+	params.p2Right = (float)(paddle2.x + paddle2.w);
+	params.p2Top = (float)paddle2.y;
+	params.p2Bottom = (float)(paddle2.y + paddle2.h);
+	params.p2Stop = params.p2Left - CHAOS_BALL_SIZE;
+	params.leftCourt = mLeftCourt.data();
+	params.leftCount = 0;
+
+	int hits;
+	switch (mKernel)
+	{
+#ifdef BALLPOOL_X86
+	case KERNEL_AVX2:
+		hits = stepAvx2(params);
+		break;
+	case KERNEL_SSE:
+		hits = stepSse(params);
+		break;
+#endif
+	default:
+		hits = stepScalar(params, 0);
+		break;
+	}
+
+	// Serve the balls that got past a paddle again, in index order so every kernel serves them the same
+	for (int i = 0; i < params.leftCount; i++)
+	{
+		serve(mLeftCourt[i]);
+	}
+	return hits;
+}
+
+void BallPool::setKernel(BallKernel kernel)
+{
+	mKernel = kernel <= bestKernel() ? kernel : bestKernel();
+}
+
+BallKernel BallPool::getKernel() const
+{
+	return mKernel;
+}
+
+BallKernel BallPool::bestKernel()
+{
+#ifdef BALLPOOL_X86
+	static const BallKernel best = cpuHasAvx2() ? KERNEL_AVX2 : KERNEL_SSE;
+	return best;
+#else
+	return KERNEL_SCALAR;
+#endif
+}
+
+const char* BallPool::kernelName(BallKernel kernel)
+{
+	switch (kernel)
+	{
+	case KERNEL_AVX2:
+		return "avx2";
+	case KERNEL_SSE:
+		return "sse";
+	default:
+		return "scalar";
+	}
+}
+
+uint64_t BallPool::checksum() const
+{
+	// FNV-1a over the bits of every field
+	uint64_t hash = 14695981039346656037ULL;
+	const std::vector<float>* fields[] = { &x, &y, &xVelocity, &yVelocity };
+	for (const std::vector<float>* field : fields)
+	{
+		for (int i = 0; i < mCount; i++)
+		{
+			uint32_t bits;
+			memcpy(&bits, &(*field)[i], sizeof(bits));
+			for (int b = 0; b < 4; b++)
+			{
+				hash = (hash ^ ((bits >> (8 * b)) & 0xFF)) * 1099511628211ULL;
+			}
+		}
+	}
+	return hash;
+}
+
+// Serve from the centre toward either player at a random angle. The ball jumps, so don't blend it across the court
+void BallPool::serve(int ball)
+{
+	x[ball] = SCREEN_WIDTH / 2 - CHAOS_BALL_SIZE / 2;
+	y[ball] = SCREEN_HEIGHT / 2 - CHAOS_BALL_SIZE / 2;
+	int speed = CHAOS_MIN_SPEED + mRng.below(CHAOS_MAX_SPEED - CHAOS_MIN_SPEED + 1);
+	xVelocity[ball] = (float)(mRng.below(2) == 1 ? speed : -speed);
+	yVelocity[ball] = .2f * (mRng.below(41) - 20);
+	prevX[ball] = x[ball];
+	prevY[ball] = y[ball];
+}
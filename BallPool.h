@@ -0,0 +1,73 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+#include "Collision.h"
+#include "Rng.h"
+
+// Chaos balls are queued as one batch of squares
+class RenderQueue;
+
+// Ways the pool can be stepped. The best one the CPU supports is picked by default
+enum BallKernel
+{
+	KERNEL_SCALAR,
+	KERNEL_SSE,
+	KERNEL_AVX2
+};
+
+// Chaos balls are smaller than the real ball so it can still be told apart
+const float CHAOS_BALL_SIZE = 6;
+
+// Horizontal speed range of a served chaos ball. The top speed stays under a paddle's width a tick,
+// so an overlap test can't miss a paddle
+const int CHAOS_MIN_SPEED = 2;
+const int CHAOS_MAX_SPEED = 6;
+
+// BallPool holds the extra balls of chaos mode as one array per field, so a tick runs over them in
+// SIMD lanes: move, bounce off the top and bottom, bounce off either paddle. Chaos balls never score.
+// One that leaves the court is served again from the centre
+class BallPool
+{
+public:
+	// Balls are served with their own random numbers, so chaos mode doesn't change the match itself
+	BallPool(uint64_t seed = 1);
+
+	// Replaces the pool with count balls served from the centre
+	void spawn(int count);
+	int getCount() const;
+
+	// Remember where every ball was before this tick moves it
+	void storePrevious();
+
+	// Advances every ball one tick. Returns how many bounced off a paddle
+	int step(const Box& paddle1, const Box& paddle2);
+
+	// Picks the kernel step uses. Falls back to the best supported one if the CPU can't run it
+	void setKernel(BallKernel kernel);
+	BallKernel getKernel() const;
+	static BallKernel bestKernel();
+	static const char* kernelName(BallKernel kernel);
+
+	// Queues every ball as one batch, between the previous and current tick
+	void render(RenderQueue& queue, double alpha);
+
+	// Hash of every ball, to check the kernels agree
+	uint64_t checksum() const;
+
+	// Ball state, one entry per ball in each array
+	std::vector<float> x, y, xVelocity, yVelocity;
+	std::vector<float> prevX, prevY;
+
+private:
+	void serve(int ball);
+
+	Rng mRng;
+	BallKernel mKernel;
+	int mCount;
+
+	// Balls that left the court during a step, served again after it. Sized with the pool
+	std::vector<int> mLeftCourt;
+
+	// Interpolated positions handed to the render queue
+	std::vector<float> mRenderX, mRenderY;
+};
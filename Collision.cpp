@@ -0,0 +1,217 @@
+#include "Collision.h"
+#include <cfloat>
+#include <cmath>
+
+// Times along one axis when the moving interval starts and stops overlapping the target interval.
+// Returns false if the intervals never overlap on this axis
+static bool sweepAxis(double start, double size, double delta, double targetStart, double targetSize, double& entry, double& exit)
+{
+	if (delta == 0)
+	{
+		// Not moving on this axis, so it either always or never overlaps
+		if (start > targetStart + targetSize || targetStart > start + size)
+		{
+			return false;
+		}
+		entry = -DBL_MAX;
+		exit = DBL_MAX;
+	}
+	else if (delta > 0)
+	{
+		entry = (targetStart - (start + size)) / delta;
+		exit = (targetStart + targetSize - start) / delta;
+	}
+	else
+	{
+		entry = (targetStart + targetSize - start) / delta;
+		exit = (targetStart - (start + size)) / delta;
+	}
+	return true;
+}
+
+bool sweepBox(const Box& moving, double dx, double dy, const Box& target, SweepHit& hit)
+{
+	// Most sweeps are nowhere near the target. Reject them with the box covering the whole path before dividing
+	double minX = dx < 0 ? moving.x + dx : moving.x;
+	double maxX = (dx > 0 ? moving.x + dx : moving.x) + moving.w;
+	double minY = dy < 0 ? moving.y + dy : moving.y;
+	double maxY = (dy > 0 ? moving.y + dy : moving.y) + moving.h;
+	if (minX > target.x + target.w || target.x > maxX || minY > target.y + target.h || target.y > maxY)
+	{
+		return false;
+	}
+
+	double entryX, exitX, entryY, exitY;
+	if (!sweepAxis(moving.x, moving.w, dx, target.x, target.w, entryX, exitX)
+		|| !sweepAxis(moving.y, moving.h, dy, target.y, target.h, entryY, exitY))
+	{
+		return false;
+	}
+
+	// The boxes overlap once both axes overlap, and stop as soon as either axis separates
+	double entry = entryX > entryY ? entryX : entryY;
+	double exit = exitX < exitY ? exitX : exitY;
+	if (entry > exit || entry > 1 || exit <= 0)
+	{
+		return false;
+	}
+
+	// The axis that started overlapping last is the face that was hit
+	if (entryX > entryY)
+	{
+		hit.normalX = dx > 0 ? -1 : 1;
+		hit.normalY = 0;
+	}
+	else
+	{
+		hit.normalX = 0;
+		hit.normalY = dy > 0 ? -1 : 1;
+	}
+	hit.time = entry > 0 ? entry : 0;
+	return true;
+}
+
+bool sweepCircle(const Box& moving, double dx, double dy, double centerX, double centerY, double radius, SweepHit& hit)
+{
+	// A point moving from the mover's centre against a circle grown by the mover's radius
+	double reach = radius + fmin(moving.w, moving.h) / 2;
+	double offsetX = moving.x + moving.w / 2 - centerX;
+	double offsetY = moving.y + moving.h / 2 - centerY;
+
+	// Quadratic for when the distance between the centres equals reach
+	double a = dx * dx + dy * dy;
+	double b = offsetX * dx + offsetY * dy;
+	double c = offsetX * offsetX + offsetY * offsetY - reach * reach;
+	double time;
+	if (c <= 0)
+	{
+		// Already touching. Only a hit if moving further in
+		if (b >= 0)
+		{
+			return false;
+		}
+		time = 0;
+	}
+	else
+	{
+		double discriminant = b * b - a * c;
+		if (a == 0 || b >= 0 || discriminant < 0)
+		{
+			return false;
+		}
+		time = (-b - sqrt(discriminant)) / a;
+		if (time > 1)
+		{
+			return false;
+		}
+	}
+
+	double contactX = offsetX + dx * time;
+	double contactY = offsetY + dy * time;
+	double distance = sqrt(contactX * contactX + contactY * contactY);
+	hit.time = time;
+	hit.normalX = distance > 0 ? contactX / distance : 0;
+	hit.normalY = distance > 0 ? contactY / distance : -1;
+	return true;
+}
+
+int sweepBoxes(const Box& moving, double dx, double dy, const Box* targets, int count, SweepHit& hit)
+{
+	int nearest = -1;
+	SweepHit candidate;
+	for (int i = 0; i < count; i++)
+	{
+		if (sweepBox(moving, dx, dy, targets[i], candidate) && (nearest == -1 || candidate.time < hit.time))
+		{
+			hit = candidate;
+			nearest = i;
+		}
+	}
+	return nearest;
+}
+
+FixedBox toFixed(const Box& box)
+{
+	FixedBox result = { Fixed::fromDouble(box.x), Fixed::fromDouble(box.y), Fixed::fromDouble(box.w), Fixed::fromDouble(box.h) };
+	return result;
+}
+
+// sweepAxis in fixed point. Times out of range saturate, which only ever makes them further out of range
+static bool sweepAxisFixed(Fixed start, Fixed size, Fixed delta, Fixed targetStart, Fixed targetSize, Fixed& entry, Fixed& exit)
+{
+	if (delta.raw == 0)
+	{
+		if (start > targetStart + targetSize || targetStart > start + size)
+		{
+			return false;
+		}
+		entry = Fixed::fromRaw(INT32_MIN);
+		exit = Fixed::fromRaw(INT32_MAX);
+	}
+	else if (delta.raw > 0)
+	{
+		entry = (targetStart - (start + size)) / delta;
+		exit = (targetStart + targetSize - start) / delta;
+	}
+	else
+	{
+		entry = (targetStart + targetSize - start) / delta;
+		exit = (targetStart - (start + size)) / delta;
+	}
+	return true;
+}
+
+bool sweepBoxFixed(const FixedBox& moving, Fixed dx, Fixed dy, const FixedBox& target, FixedHit& hit)
+{
+	Fixed zero = Fixed::fromRaw(0);
+	Fixed minX = dx < zero ? moving.x + dx : moving.x;
+	Fixed maxX = (dx > zero ? moving.x + dx : moving.x) + moving.w;
+	Fixed minY = dy < zero ? moving.y + dy : moving.y;
+	Fixed maxY = (dy > zero ? moving.y + dy : moving.y) + moving.h;
+	if (minX > target.x + target.w || target.x > maxX || minY > target.y + target.h || target.y > maxY)
+	{
+		return false;
+	}
+
+	Fixed entryX, exitX, entryY, exitY;
+	if (!sweepAxisFixed(moving.x, moving.w, dx, target.x, target.w, entryX, exitX)
+		|| !sweepAxisFixed(moving.y, moving.h, dy, target.y, target.h, entryY, exitY))
+	{
+		return false;
+	}
+
+	Fixed entry = fixedMax(entryX, entryY);
+	Fixed exit = fixedMin(exitX, exitY);
+	if (entry > exit || entry.raw > FIXED_ONE || exit <= zero)
+	{
+		return false;
+	}
+
+	if (entryX > entryY)
+	{
+		hit.normalX = dx > zero ? -1 : 1;
+		hit.normalY = 0;
+	}
+	else
+	{
+		hit.normalX = 0;
+		hit.normalY = dy > zero ? -1 : 1;
+	}
+	hit.time = fixedMax(entry, zero);
+	return true;
+}
+
+int sweepBoxesFixed(const FixedBox& moving, Fixed dx, Fixed dy, const FixedBox* targets, int count, FixedHit& hit)
+{
+	int nearest = -1;
+	FixedHit candidate;
+	for (int i = 0; i < count; i++)
+	{
+		if (sweepBoxFixed(moving, dx, dy, targets[i], candidate) && (nearest == -1 || candidate.time < hit.time))
+		{
+			hit = candidate;
+			nearest = i;
+		}
+	}
+	return nearest;
+}
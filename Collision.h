@@ -0,0 +1,48 @@
+#pragma once
+#include "Fixed.h"
+
+// Axis aligned box: top left corner and dimensions
+struct Box
+{
+	double x, y, w, h;
+};
+
+// Where a sweep first touched something. time is the fraction of the motion travelled before contact,
+// and the normal points out of the surface that was hit
+struct SweepHit
+{
+	double time;
+	double normalX;
+	double normalY;
+};
+
+// Sweeps a box along (dx, dy) against a static box. Returns true and fills hit if they touch during the
+// motion. Boxes that already overlap hit at time 0, unless the mover is only touching and moving away
+bool sweepBox(const Box& moving, double dx, double dy, const Box& target, SweepHit& hit);
+
+// Sweeps the circle inscribed in a box along (dx, dy) against a static circle. Same rules as sweepBox
+bool sweepCircle(const Box& moving, double dx, double dy, double centerX, double centerY, double radius, SweepHit& hit);
+
+// Sweeps a box against many static boxes. Returns the index of the earliest hit and fills hit, or -1
+int sweepBoxes(const Box& moving, double dx, double dy, const Box* targets, int count, SweepHit& hit);
+
+// The box and hit again in fixed point, for the fixed point ball physics. A box face is always axis
+// aligned, so the normal is a whole number
+struct FixedBox
+{
+	Fixed x, y, w, h;
+};
+
+struct FixedHit
+{
+	Fixed time;
+	int normalX;
+	int normalY;
+};
+
+// Rounds a box to the fixed point grid
+FixedBox toFixed(const Box& box);
+
+// sweepBox and sweepBoxes in fixed point, with the same rules
+bool sweepBoxFixed(const FixedBox& moving, Fixed dx, Fixed dy, const FixedBox& target, FixedHit& hit);
+int sweepBoxesFixed(const FixedBox& moving, Fixed dx, Fixed dy, const FixedBox* targets, int count, FixedHit& hit);
@@ -0,0 +1,87 @@
+#include "CourtLayer.h"
+#include "RenderStats.h"
+#include <stdio.h>
+
+CourtLayer::CourtLayer()
+{
+	mTexture = NULL;
+	mWidth = 0;
+	mHeight = 0;
+	mDirty = true;
+	mRebuildCount = 0;
+}
+
+CourtLayer::~CourtLayer()
+{
+	free();
+}
+
+bool CourtLayer::create(SDL_Renderer* renderer, int width, int height)
+{
+	free();
+
+	mTexture = createTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, width, height);
+	if (mTexture == NULL)
+	{
+		printf("Unable to create court layer! SDL Error: %s\n", SDL_GetError());
+		return false;
+	}
+
+	mWidth = width;
+	mHeight = height;
+	mDirty = true;
+	return true;
+}
+
+void CourtLayer::free()
+{
+	if (mTexture != NULL)
+	{
+		SDL_DestroyTexture(mTexture);
+		mTexture = NULL;
+		mWidth = 0;
+		mHeight = 0;
+	}
+}
+
+bool CourtLayer::isReady()
+{
+	return mTexture != NULL;
+}
+
+void CourtLayer::invalidate()
+{
+	mDirty = true;
+}
+
+bool CourtLayer::isDirty()
+{
+	return mDirty;
+}
+
+void CourtLayer::beginRebuild(SDL_Renderer* renderer)
+{
+	SDL_SetRenderTarget(renderer, mTexture);
+	SDL_SetRenderDrawColor(renderer, 0x00, 0x00, 0x00, 0xFF);
+	SDL_RenderClear(renderer);
+}
+
+void CourtLayer::endRebuild(SDL_Renderer* renderer)
+{
+	SDL_SetRenderTarget(renderer, NULL);
+	mDirty = false;
+	mRebuildCount++;
+}
+
+void CourtLayer::render(RenderQueue& queue)
+{
+	// The layer is opaque, so copy it without blending
+	SDL_Rect whole = { 0, 0, mWidth, mHeight };
+	const SDL_Color white = { 0xFF, 0xFF, 0xFF, 0xFF };
+	queue.addQuad(mTexture, whole, whole, white, LAYER_BACKGROUND, SDL_BLENDMODE_NONE);
+}
+
+int CourtLayer::getRebuildCount()
+{
+	return mRebuildCount;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <SDL.h>
+#include "RenderQueue.h"
+
+// CourtLayer keeps everything that doesn't move (title, court markings, scores, idle messages) in a
+// render target texture. It is redrawn only when invalidated, and each frame it costs a single copy
+class CourtLayer
+{
+public:
+	CourtLayer();
+	~CourtLayer();
+
+	// Creates the target texture. Returns false if the renderer can't render to textures
+	bool create(SDL_Renderer* renderer, int width, int height);
+
+	// Deallocates the texture
+	void free();
+
+	// True once create() has succeeded
+	bool isReady();
+
+	// Marks the contents stale, e.g. after a score changes or the renderer lost its targets
+	void invalidate();
+	bool isDirty();
+
+	// Points the renderer at the layer and clears it. Draw the static content, then call endRebuild()
+	void beginRebuild(SDL_Renderer* renderer);
+	void endRebuild(SDL_Renderer* renderer);
+
+	// Queues the layer as one opaque copy covering the screen
+	void render(RenderQueue& queue);
+
+	// Times the layer has been redrawn
+	int getRebuildCount();
+
+private:
+	SDL_Texture* mTexture;
+	int mWidth;
+	int mHeight;
+	bool mDirty;
+	int mRebuildCount;
+};
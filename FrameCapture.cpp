@@ -0,0 +1,252 @@
+#include "FrameCapture.h"
+#include "RenderStats.h"
+#include "Trace.h"
+
+FrameCapture::FrameCapture()
+{
+	mTargets[0] = NULL;
+	mTargets[1] = NULL;
+	mCurrent = 0;
+	mPending = false;
+	mWidth = 0;
+	mHeight = 0;
+	mPitch = 0;
+	mFile = NULL;
+	mPath = NULL;
+	mReady = NULL;
+	mWriter = NULL;
+	mRunning = false;
+	mWritten = 0;
+	mWriteFailed = false;
+	mFrameOverheadMs = 0;
+	mFirstFrameTime = 0;
+	mLastFrameTime = 0;
+	mFrames = 0;
+	mDropped = 0;
+	mRepeats = 0;
+	mOverheadTotalMs = 0;
+	mOverheadMaxMs = 0;
+}
+
+FrameCapture::~FrameCapture()
+{
+	close(NULL);
+}
+
+bool FrameCapture::open(SDL_Renderer* renderer, const char* path, int width, int height)
+{
+	for (int i = 0; i < 2; i++)
+	{
+		mTargets[i] = createTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, width, height);
+		if (mTargets[i] == NULL)
+		{
+			printf("Unable to create capture target! SDL Error: %s\n", SDL_GetError());
+			close(NULL);
+			return false;
+		}
+	}
+
+	mFile = fopen(path, "wb");
+	if (mFile == NULL)
+	{
+		printf("Unable to open %s for capture!\n", path);
+		close(NULL);
+		return false;
+	}
+	mPath = path;
+	mWidth = width;
+	mHeight = height;
+	mPitch = width * 4;
+
+	// Every buffer is allocated up front, so capturing doesn't allocate while playing
+	for (int i = 0; i < CAPTURE_SLOTS; i++)
+	{
+		mSlots[i].resize(mPitch * height);
+		mFree.push(i);
+	}
+
+	mReady = SDL_CreateSemaphore(0);
+	mRunning = true;
+	mWriter = mReady != NULL ? SDL_CreateThread(runWriter, "capture", this) : NULL;
+	if (mWriter == NULL)
+	{
+		printf("Unable to start the capture writer! SDL Error: %s\n", SDL_GetError());
+		close(NULL);
+		return false;
+	}
+	return true;
+}
+
+bool FrameCapture::isOpen()
+{
+	return mWriter != NULL;
+}
+
+void FrameCapture::beginFrame(SDL_Renderer* renderer)
+{
+	TRACE_ZONE("capture");
+	Uint64 start = SDL_GetPerformanceCounter();
+
+	// The last frame has had a whole frame to finish drawing by now
+	readBack(renderer, false);
+
+	mCurrent = 1 - mCurrent;
+	SDL_SetRenderTarget(renderer, mTargets[mCurrent]);
+	mFrameOverheadMs = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+	if (mFrames == 0)
+	{
+		mFirstFrameTime = start;
+	}
+}
+
+void FrameCapture::endFrame(SDL_Renderer* renderer)
+{
+	TRACE_ZONE("capture");
+	Uint64 start = SDL_GetPerformanceCounter();
+	SDL_SetRenderTarget(renderer, NULL);
+	SDL_RenderCopy(renderer, mTargets[mCurrent], NULL, NULL);
+	mPending = true;
+
+	mLastFrameTime = SDL_GetPerformanceCounter();
+	mFrameOverheadMs += (mLastFrameTime - start) * 1000.0 / SDL_GetPerformanceFrequency();
+	mFrames++;
+	mOverheadTotalMs += mFrameOverheadMs;
+	if (mFrameOverheadMs > mOverheadMaxMs)
+	{
+		mOverheadMaxMs = mFrameOverheadMs;
+	}
+}
+
+void FrameCapture::readBack(SDL_Renderer* renderer, bool wait)
+{
+	if (!mPending)
+	{
+		return;
+	}
+	mPending = false;
+
+	// No free buffer means the writer is behind. Drop the frame rather than wait for it. The next frame
+	// saved takes its place in the file
+	int slot;
+	while (wait && !mFree.pop(slot))
+	{
+		SDL_Delay(1);
+	}
+	if (!wait && !mFree.pop(slot))
+	{
+		mDropped++;
+		mRepeats++;
+		return;
+	}
+
+	SDL_SetRenderTarget(renderer, mTargets[mCurrent]);
+	if (SDL_RenderReadPixels(renderer, NULL, SDL_PIXELFORMAT_ARGB8888, mSlots[slot].data(), mPitch) != 0)
+	{
+		printf("Unable to read back a captured frame! SDL Error: %s\n", SDL_GetError());
+		mFree.push(slot);
+		mDropped++;
+		mRepeats++;
+		return;
+	}
+	CaptureFrame frame = { slot, 1 + mRepeats };
+	mRepeats = 0;
+	mFilled.push(frame);
+	SDL_SemPost(mReady);
+}
+
+void FrameCapture::close(SDL_Renderer* renderer)
+{
+	if (mWriter != NULL)
+	{
+		// Save the frame still on the GPU, then let the writer finish the queue. The last frame carries
+		// the drops before it, so it waits for a buffer rather than being dropped too
+		if (renderer != NULL)
+		{
+			readBack(renderer, true);
+			SDL_SetRenderTarget(renderer, NULL);
+		}
+		mRunning = false;
+		SDL_SemPost(mReady);
+		SDL_WaitThread(mWriter, NULL);
+		mWriter = NULL;
+	}
+	if (mReady != NULL)
+	{
+		SDL_DestroySemaphore(mReady);
+		mReady = NULL;
+	}
+	if (mFile != NULL)
+	{
+		fclose(mFile);
+		mFile = NULL;
+	}
+	for (int i = 0; i < 2; i++)
+	{
+		if (mTargets[i] != NULL)
+		{
+			SDL_DestroyTexture(mTargets[i]);
+			mTargets[i] = NULL;
+		}
+	}
+	mPending = false;
+}
+
+void FrameCapture::printReport()
+{
+	if (mPath == NULL)
+	{
+		return;
+	}
+
+	// Frames come at the display's refresh rate, so that is the video's frame rate
+	double seconds = (double)(mLastFrameTime - mFirstFrameTime) / SDL_GetPerformanceFrequency();
+	int frameRate = seconds > 0 ? (int)((mFrames - 1) / seconds + 0.5) : 60;
+	printf("Capture: %d frames written to %s, %d of them repeats standing in for dropped frames\n", mWritten.load(), mPath,
+		mDropped);
+	printf("  %dx%d raw BGRA at %d fps. Convert with: ffmpeg -f rawvideo -pixel_format bgra -video_size %dx%d -framerate %d -i %s capture.mp4\n",
+		mWidth, mHeight, frameRate, mWidth, mHeight, frameRate, mPath);
+	printf("  main thread cost: %.3f / %.3f ms (average / worst over %d frames)\n",
+		mFrames > 0 ? mOverheadTotalMs / mFrames : 0, mOverheadMaxMs, mFrames);
+}
+
+int FrameCapture::runWriter(void* data)
+{
+	((FrameCapture*)data)->writeFrames();
+	return 0;
+}
+
+void FrameCapture::writeFrames()
+{
+	TRACE_THREAD("capture");
+
+	// Every queued frame posts once, and close() posts once more after the last one
+	while (true)
+	{
+		SDL_SemWait(mReady);
+		CaptureFrame frame;
+		if (!mFilled.pop(frame))
+		{
+			if (!mRunning)
+			{
+				break;
+			}
+			continue;
+		}
+
+		TRACE_ZONE("write frame");
+		const std::vector<Uint8>& pixels = mSlots[frame.slot];
+		for (int i = 0; i < frame.copies && !mWriteFailed; i++)
+		{
+			if (fwrite(pixels.data(), 1, pixels.size(), mFile) != pixels.size())
+			{
+				printf("Unable to write to %s! Capture stopped\n", mPath);
+				mWriteFailed = true;
+			}
+			else
+			{
+				mWritten++;
+			}
+		}
+		mFree.push(frame.slot);
+	}
+}
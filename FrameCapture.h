@@ -0,0 +1,89 @@
+#pragma once
+#include <SDL.h>
+#include <stdio.h>
+#include <atomic>
+#include <vector>
+#include "SpscQueue.h"
+
+// Staging buffers in the capture ring. Frames wait in them for the writer, so this is how far the disk can
+// fall behind before frames are dropped
+const int CAPTURE_SLOTS = 8;
+
+// A frame queued for the writer, and how many times it goes in the file: once, plus once for every frame
+// dropped just before it
+struct CaptureFrame
+{
+	int slot;
+	int copies;
+};
+
+// FrameCapture records what the game draws to a raw video file. Each frame is drawn into one of two target
+// textures and copied to the window. The next frame reads the other one back into a free staging buffer,
+// a frame after it was drawn, so the GPU has had a whole frame to finish it. A writer thread saves the
+// buffers to disk. When none is free because the writer has fallen behind, the frame is dropped instead
+// of waiting for it, and the next frame saved is written once more in its place. The file keeps one frame
+// for every frame drawn, so it plays back at the display's rate in step with the game
+class FrameCapture
+{
+public:
+	FrameCapture();
+	~FrameCapture();
+
+	// Creates the targets and buffers, opens the file and starts the writer. Returns false if any of it fails
+	bool open(SDL_Renderer* renderer, const char* path, int width, int height);
+
+	// True between open() and close()
+	bool isOpen();
+
+	// Reads back the last frame, then points the renderer at a target for this one
+	void beginFrame(SDL_Renderer* renderer);
+
+	// Points the renderer back at the window and copies the frame to it. Anything drawn after this, like
+	// the performance overlay, is left out of the recording
+	void endFrame(SDL_Renderer* renderer);
+
+	// Reads back the last frame, waits for the writer to save everything queued, and closes the file
+	void close(SDL_Renderer* renderer);
+
+	// Prints frames written and dropped, and what capturing cost the main thread
+	void printReport();
+
+private:
+	static int runWriter(void* data);
+	void writeFrames();
+
+	// Reads the target last drawn into a free buffer and queues it for the writer. With wait set it waits
+	// for a buffer to come free instead of dropping the frame
+	void readBack(SDL_Renderer* renderer, bool wait);
+
+	SDL_Texture* mTargets[2];
+	int mCurrent;
+	bool mPending;
+	int mWidth;
+	int mHeight;
+	int mPitch;
+	FILE* mFile;
+	const char* mPath;
+
+	// Slot indexes go to the writer through mFilled and come back through mFree. mReady counts filled slots
+	std::vector<Uint8> mSlots[CAPTURE_SLOTS];
+	SpscQueue<CaptureFrame, CAPTURE_SLOTS> mFilled;
+	SpscQueue<int, CAPTURE_SLOTS> mFree;
+	SDL_sem* mReady;
+	SDL_Thread* mWriter;
+	std::atomic<bool> mRunning;
+	std::atomic<int> mWritten;
+	std::atomic<bool> mWriteFailed;
+
+	// Main thread time spent in beginFrame() and endFrame(), and when the first and last frames were drawn
+	double mFrameOverheadMs;
+	Uint64 mFirstFrameTime;
+	Uint64 mLastFrameTime;
+	int mFrames;
+	int mDropped;
+
+	// Frames dropped since the last one queued, which it stands in for
+	int mRepeats;
+	double mOverheadTotalMs;
+	double mOverheadMaxMs;
+};
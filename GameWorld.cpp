@@ -0,0 +1,563 @@
+#include "GameWorld.h"
+#include <string.h>
+
+int quantizeAxis(double axis)
+{
+	return (int)lround(fmax(-1, fmin(1, axis)) * AXIS_STEPS);
+}
+
+// Initialize paddles, the AI's velocity and the ball
+GameWorld::GameWorld(uint64_t seed, const DifficultyParams& difficulty)
+	: rng(seed),
+	  player1(10, 40, 10, 40),
+	  player2(SCREEN_WIDTH - 20, SCREEN_HEIGHT - 80, 10, 40),
+	  ball(SCREEN_WIDTH / 2 - 5, SCREEN_HEIGHT / 2 - 5, 10, 10, rng),
+	  difficulty(difficulty),
+	  chaosBalls(seed)
+{
+	player2.yVelocity /= difficulty.aiSlowdownMin;
+}
+
+void GameWorld::step(const GameInputs& inputs)
+{
+	eventCount = 0;
+
+	// Keep where everything started this tick so frames can be drawn between ticks
+	ball.storePrevious();
+	player1.storePrevious();
+	player2.storePrevious();
+	chaosBalls.storePrevious();
+
+	if (inputs.advance)
+	{
+		advance();
+	}
+
+	// Ball is in play
+	if (state == STATE_PLAY)
+	{
+		movePaddle(player1, inputs.player1Axis);
+		if (player2Human)
+		{
+			movePaddle(player2, inputs.player2Axis);
+		}
+		updatePlay();
+		chaosBalls.step(player1.box(), player2.box());
+	}
+}
+
+// User pressed enter, change the game state
+void GameWorld::advance()
+{
+	if (state == STATE_START)
+	{
+		state = STATE_SERVE;
+	}
+	else if (state == STATE_SERVE)
+	{
+		state = STATE_PLAY;
+	}
+	else if (state == STATE_DONE)
+	{
+		state = STATE_SERVE;
+		ball.reset(rng);
+		player1Score = 0;
+		player2Score = 0;
+		sevenFlag = false;
+		player1.height = 40;
+		player2.height = 40;
+		ai.replan(true);
+	}
+	else
+	{
+		return;
+	}
+
+	emit(EVENT_STATE_CHANGED);
+}
+
+// Move a player's paddle in proportion to the stick or keys, stopping at the edges of the screen
+void GameWorld::movePaddle(Paddle& paddle, double axis)
+{
+	if (fixedPoint)
+	{
+		Fixed move = Fixed::fromDouble(PLAYER1_SPEED) * Fixed::fromInt(quantizeAxis(axis)) / Fixed::fromInt(AXIS_STEPS);
+		Fixed bottom = Fixed::fromDouble(SCREEN_HEIGHT - paddle.height);
+		paddle.y = fixedMax(Fixed::fromRaw(0), fixedMin(bottom, Fixed::fromDouble(paddle.y) + move)).toDouble();
+		return;
+	}
+
+	axis = (double)quantizeAxis(axis) / AXIS_STEPS;
+	paddle.y = fmax(0, fmin(SCREEN_HEIGHT - paddle.height, paddle.y + axis * PLAYER1_SPEED));
+}
+
+void GameWorld::updatePlay()
+{
+	// If there is no zig zag serves, the ball keeps moving normally
+	if (!zigzagFlag)
+	{
+		moveBall();
+	}
+	else
+	{   // After moving in its direction 20 times, it reverses, giving a zigzag pattern
+		if (zigzagTot < 20 * ball.height)
+		{
+			moveBall();
+			zigzagTot += ball.height;
+		}
+		else
+		{
+			ball.yVelocity *= -1;
+			zigzagTot = 0;
+			ai.replan(true);
+		}
+	}
+
+	// Player1 scores
+	if (ball.x >= SCREEN_WIDTH)
+	{
+		emit(EVENT_PLAYER1_SCORE);
+
+		player1Score += 1;
+		ball.reset(rng);
+		ai.replan(true);
+	}
+
+	// Player2 scores. Turn off zigzag flag
+	if (ball.x <= 0)
+	{
+		emit(EVENT_PLAYER2_SCORE);
+
+		player2Score += 1;
+		zigzagFlag = false;
+		ball.reset(rng);
+		ai.replan(true);
+	}
+
+	if (player1Score == WINNING_SCORE)
+	{
+		emit(EVENT_PLAYER1_WIN);
+
+		winningPlayer = 1;
+		state = STATE_DONE;
+	}
+	else if (player2Score == WINNING_SCORE)
+	{
+		emit(EVENT_PLAYER2_WIN);
+
+		winningPlayer = 2;
+		state = STATE_DONE;
+	}
+
+	// AI for player 2 follows its plan, which is only worked out again when the ball changes course
+	if (!player2Human)
+	{
+		ai.update(ball, zigzagFlag ? 2 : 1, player2, difficulty.aiSkill, rng);
+		player2.y = snap(player2.y);
+	}
+
+	if (ball.xVelocity > 0)
+	{
+		// Randomly reverse at midpoint of screen once player 1 is past the reverse score (6 by default)
+		if (player1Score > difficulty.reverseScore && ball.x - ball.width / 2 > SCREEN_WIDTH / 2
+			&& ball.x < SCREEN_WIDTH / 2 + ball.width && !rng.below(difficulty.reverseOdds))
+		{
+			ball.xVelocity = speedUp(ball.xVelocity, -1.05);
+			ai.replan(true);
+		}
+
+		// Past the resize score (8 by default), player1 gets smaller and player 2 gets bigger.
+		// Flag ensures this block of code executes only once
+		if (!sevenFlag && player1Score > difficulty.resizeScore)
+		{
+			sevenFlag = true;
+			player1.height = difficulty.player1ResizeHeight;
+			player2.height = difficulty.player2ResizeHeight;
+		}
+	}
+}
+
+// Moves the ball one tick along its velocity. The path is swept, so the ball bounces off whatever it
+// reaches first (paddle or wall) and carries on with the rest of its motion, however fast it is going
+void GameWorld::moveBall()
+{
+	if (fixedPoint)
+	{
+		moveBallFixed();
+		return;
+	}
+
+	double remaining = 1;
+	for (int bounce = 0; bounce < MAX_BALL_BOUNCES && remaining > 0; bounce++)
+	{
+		// A zigzag moves the ball twice as fast vertically
+		double dx = ball.xVelocity * remaining;
+		double dy = (zigzagFlag ? 2 : 1) * ball.yVelocity * remaining;
+
+		// Earliest paddle contact
+		Box paddles[2] = { player1.box(), player2.box() };
+		SweepHit hit;
+		int paddle = sweepBoxes(ball.box(), dx, dy, paddles, 2, hit);
+		double time = paddle == -1 ? 1 : hit.time;
+
+		// Earliest bumper contact, from the cells of the arena grid the path crosses. A paddle wins a tie
+		SweepHit bumperHit;
+		int bumper = arena.sweep(ball.box(), dx, dy, bumperHit);
+		if (bumper != -1 && bumperHit.time < time)
+		{
+			paddle = -1;
+			time = bumperHit.time;
+		}
+		else
+		{
+			bumper = -1;
+		}
+
+		// Earliest wall contact. A paddle wins a tie, like it did when collisions were checked first
+		int wall = 0;
+		if (dy < 0 && -ball.y / dy < time)
+		{
+			wall = -1;
+			time = fmax(0, -ball.y / dy);
+		}
+		else if (dy > 0 && (SCREEN_HEIGHT - ball.height - ball.y) / dy < time)
+		{
+			wall = 1;
+			time = fmax(0, (SCREEN_HEIGHT - ball.height - ball.y) / dy);
+		}
+
+		// Travel to the contact, then bounce
+		ball.x += dx * time;
+		ball.y += dy * time;
+		remaining *= 1 - time;
+
+		if (wall != 0)
+		{
+			hitWall(wall);
+		}
+		else if (bumper != -1)
+		{
+			hitBumper(bumperHit);
+		}
+		else if (paddle == 0)
+		{
+			hitPlayer1();
+		}
+		else if (paddle == 1)
+		{
+			hitPlayer2();
+		}
+		else
+		{
+			remaining = 0;
+		}
+	}
+}
+
+// moveBall in fixed point. The ball's position and velocity are rounded onto the fixed point grid as the
+// tick starts and stay on it. Bumpers are still swept in doubles, from the ball's fixed point box, and the
+// ball stops a step short of a bumper so rounding can never leave it inside one
+void GameWorld::moveBallFixed()
+{
+	Fixed zero = Fixed::fromRaw(0);
+	Fixed one = Fixed::fromInt(1);
+	Fixed remaining = one;
+	for (int bounce = 0; bounce < MAX_BALL_BOUNCES && remaining > zero; bounce++)
+	{
+		FixedBox box = toFixed(ball.box());
+		Fixed dx = Fixed::fromDouble(ball.xVelocity) * remaining;
+		Fixed dy = Fixed::fromInt(zigzagFlag ? 2 : 1) * Fixed::fromDouble(ball.yVelocity) * remaining;
+
+		// Earliest paddle contact
+		FixedBox paddles[2] = { toFixed(player1.box()), toFixed(player2.box()) };
+		FixedHit hit;
+		int paddle = sweepBoxesFixed(box, dx, dy, paddles, 2, hit);
+		Fixed time = paddle == -1 ? one : hit.time;
+
+		// Earliest bumper contact. A paddle wins a tie
+		Box start = { box.x.toDouble(), box.y.toDouble(), box.w.toDouble(), box.h.toDouble() };
+		SweepHit bumperHit;
+		int bumper = arena.sweep(start, dx.toDouble(), dy.toDouble(), bumperHit);
+		if (bumper != -1)
+		{
+			Fixed bumperTime = Fixed::fromRaw((int64_t)fmax(0, floor(bumperHit.time * FIXED_ONE) - 1));
+			if (bumperTime < time)
+			{
+				paddle = -1;
+				time = bumperTime;
+			}
+			else
+			{
+				bumper = -1;
+			}
+		}
+
+		// Earliest wall contact. A paddle wins a tie
+		int wall = 0;
+		Fixed bottom = Fixed::fromInt(SCREEN_HEIGHT) - box.h;
+		if (dy < zero && -box.y / dy < time)
+		{
+			wall = -1;
+			time = fixedMax(zero, -box.y / dy);
+		}
+		else if (dy > zero && (bottom - box.y) / dy < time)
+		{
+			wall = 1;
+			time = fixedMax(zero, (bottom - box.y) / dy);
+		}
+
+		// Travel to the contact, then bounce
+		ball.x = (box.x + dx * time).toDouble();
+		ball.y = (box.y + dy * time).toDouble();
+		ball.xVelocity = snap(ball.xVelocity);
+		ball.yVelocity = snap(ball.yVelocity);
+		remaining = remaining * (one - time);
+
+		if (wall != 0)
+		{
+			hitWall(wall);
+		}
+		else if (bumper != -1)
+		{
+			hitBumper(bumperHit);
+		}
+		else if (paddle == 0)
+		{
+			hitPlayer1();
+		}
+		else if (paddle == 1)
+		{
+			hitPlayer2();
+		}
+		else
+		{
+			remaining = zero;
+		}
+	}
+}
+
+// Multiplies a ball velocity by factor and clamps it to MAX_BALL_SPEED. In fixed point mode the product
+// is a fixed point multiply
+double GameWorld::speedUp(double velocity, double factor) const
+{
+	if (fixedPoint)
+	{
+		Fixed limit = Fixed::fromDouble(MAX_BALL_SPEED);
+		Fixed scaled = Fixed::fromDouble(velocity) * Fixed::fromDouble(factor);
+		return fixedMax(-limit, fixedMin(limit, scaled)).toDouble();
+	}
+	return fmax(-MAX_BALL_SPEED, fmin(MAX_BALL_SPEED, velocity * factor));
+}
+
+// A random vertical speed after a hit, from 0 to 2 pixels a tick in tenths
+double GameWorld::randomSpin(bool negative)
+{
+	int tenths = rng.below(21);
+	if (fixedPoint)
+	{
+		Fixed spin = Fixed::fromRaw(FIXED_ONE / 10) * Fixed::fromInt(tenths);
+		return (negative ? -spin : spin).toDouble();
+	}
+	return negative ? -.1 * tenths : .1 * tenths;
+}
+
+// Rounds a value onto the fixed point grid in fixed point mode, and leaves it alone otherwise
+double GameWorld::snap(double value) const
+{
+	return fixedPoint ? Fixed::fromDouble(value).toDouble() : value;
+}
+
+void GameWorld::hitPlayer1()
+{
+	emit(EVENT_PLAYER1_HIT);
+	ai.replan(true);
+
+	// Turn off zigzag serve if player1 hits it
+	zigzagFlag = false;
+
+	// Move ball on collision in front of paddle. Several collisions happen when the ball hits the top of the paddle
+	ball.x = player1.x + player1.width;
+
+	// Send it back a little faster, up to the top speed
+	ball.xVelocity = speedUp(ball.xVelocity, -1.05);
+
+	// Randomize yVelocity of ball, keeping its direction
+	ball.yVelocity = randomSpin(ball.yVelocity < 0);
+}
+
+void GameWorld::hitPlayer2()
+{
+	emit(EVENT_PLAYER2_HIT);
+	ai.replan(true);
+
+	ball.x = player2.x - player2.width;
+
+	// Player 2 will sometimes serve the ball in a zigzag and speed it up once player1 is past the zigzag score (3 by default)
+	if (player1Score > difficulty.zigzagScore && !rng.below(difficulty.zigzagOdds))
+	{
+		zigzagFlag = true;
+		ball.xVelocity = speedUp(ball.xVelocity, 1.5);
+		ball.yVelocity = speedUp(ball.yVelocity, 1.5);
+	}
+	ball.xVelocity = speedUp(ball.xVelocity, -1.05);
+	ball.yVelocity = randomSpin(ball.yVelocity < 0);
+
+	// Player2 gets a random velocity divided by it to make the AI have a variable skill. Not too good or bad.
+	player2.yVelocity = PADDLE_SPEED / (difficulty.aiSlowdownMin + rng.below(difficulty.aiSlowdownRange));
+}
+
+// If the ball hits the top (-1) or bottom (1) of screen, reverse its direction
+void GameWorld::hitWall(int wall)
+{
+	emit(EVENT_WALL_HIT);
+	ai.replan(false);
+
+	ball.y = wall < 0 ? 0 : SCREEN_HEIGHT - ball.height;
+	ball.yVelocity *= -1;
+}
+
+// FNV-1a over every field that affects what happens next. Doubles are hashed by their bits
+static void hashBytes(uint64_t& hash, const void* data, size_t size)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash = (hash ^ bytes[i]) * 1099511628211ULL;
+	}
+}
+
+static void hashDouble(uint64_t& hash, double value)
+{
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	hashBytes(hash, &bits, sizeof(bits));
+}
+
+static void hashPaddle(uint64_t& hash, const Paddle& paddle)
+{
+	hashDouble(hash, paddle.x);
+	hashDouble(hash, paddle.y);
+	hashDouble(hash, paddle.width);
+	hashDouble(hash, paddle.height);
+	hashDouble(hash, paddle.yVelocity);
+}
+
+uint64_t GameWorld::checksum() const
+{
+	uint64_t hash = 14695981039346656037ULL;
+	hashBytes(hash, &rng.state, sizeof(rng.state));
+	hashPaddle(hash, player1);
+	hashPaddle(hash, player2);
+	hashDouble(hash, ball.x);
+	hashDouble(hash, ball.y);
+	hashDouble(hash, ball.xVelocity);
+	hashDouble(hash, ball.yVelocity);
+	hashDouble(hash, ai.targetY);
+	hashDouble(hash, ai.aimOffset);
+
+	int values[] = { player1Score, player2Score, winningPlayer, (int)state, sevenFlag, zigzagFlag, zigzagTot, ai.wait, (int)ai.pending };
+	hashBytes(hash, values, sizeof(values));
+	return hash;
+}
+
+void GameWorld::save(GameSnapshot& snapshot) const
+{
+	snapshot.rngState = rng.state;
+	snapshot.ballX = ball.x;
+	snapshot.ballY = ball.y;
+	snapshot.ballXVelocity = ball.xVelocity;
+	snapshot.ballYVelocity = ball.yVelocity;
+	snapshot.player1Y = player1.y;
+	snapshot.player1Height = player1.height;
+	snapshot.player2Y = player2.y;
+	snapshot.player2Height = player2.height;
+	snapshot.player2Speed = player2.yVelocity;
+	snapshot.aiTargetY = ai.targetY;
+	snapshot.aiAimOffset = ai.aimOffset;
+	snapshot.aiWait = ai.wait;
+	snapshot.aiPending = ai.pending;
+	snapshot.player1Score = player1Score;
+	snapshot.player2Score = player2Score;
+	snapshot.winningPlayer = winningPlayer;
+	snapshot.state = state;
+	snapshot.zigzagTot = zigzagTot;
+	snapshot.sevenFlag = sevenFlag;
+	snapshot.zigzagFlag = zigzagFlag;
+}
+
+void GameWorld::load(const GameSnapshot& snapshot)
+{
+	rng.state = snapshot.rngState;
+	ball.x = snapshot.ballX;
+	ball.y = snapshot.ballY;
+	ball.xVelocity = snapshot.ballXVelocity;
+	ball.yVelocity = snapshot.ballYVelocity;
+	player1.y = snapshot.player1Y;
+	player1.height = snapshot.player1Height;
+	player2.y = snapshot.player2Y;
+	player2.height = snapshot.player2Height;
+	player2.yVelocity = snapshot.player2Speed;
+	ai.targetY = snapshot.aiTargetY;
+	ai.aimOffset = snapshot.aiAimOffset;
+	ai.wait = snapshot.aiWait;
+	ai.pending = snapshot.aiPending;
+	player1Score = snapshot.player1Score;
+	player2Score = snapshot.player2Score;
+	winningPlayer = snapshot.winningPlayer;
+	state = snapshot.state;
+	zigzagTot = snapshot.zigzagTot;
+	sevenFlag = snapshot.sevenFlag;
+	zigzagFlag = snapshot.zigzagFlag;
+	eventCount = 0;
+}
+
+// Bounce off a bumper by reflecting the velocity about the surface it hit. Speed is kept, except that the
+// ball is kept crossing the court at MIN_BALL_X_SPEED or more, the way it was already going. When that way
+// leads back into a round bumper's side it goes the other way instead, or it would hit it again at once
+void GameWorld::hitBumper(const SweepHit& hit)
+{
+	emit(EVENT_BUMPER_HIT);
+	ai.replan(true);
+
+	if (fixedPoint)
+	{
+		Fixed normalX = Fixed::fromDouble(hit.normalX);
+		Fixed normalY = Fixed::fromDouble(hit.normalY);
+		Fixed xVelocity = Fixed::fromDouble(ball.xVelocity);
+		Fixed yVelocity = Fixed::fromDouble(ball.yVelocity);
+		Fixed twiceAlong = Fixed::fromInt(2) * (xVelocity * normalX + yVelocity * normalY);
+		xVelocity = xVelocity - twiceAlong * normalX;
+		Fixed least = Fixed::fromDouble(MIN_BALL_X_SPEED);
+		if (xVelocity < least && -xVelocity < least)
+		{
+			Fixed zero = Fixed::fromRaw(0);
+			bool left = normalX == zero ? xVelocity < zero : normalX < zero;
+			xVelocity = left ? -least : least;
+		}
+		ball.xVelocity = xVelocity.toDouble();
+		ball.yVelocity = (yVelocity - twiceAlong * normalY).toDouble();
+		return;
+	}
+
+	double along = ball.xVelocity * hit.normalX + ball.yVelocity * hit.normalY;
+	ball.xVelocity -= 2 * along * hit.normalX;
+	ball.yVelocity -= 2 * along * hit.normalY;
+	if (fabs(ball.xVelocity) < MIN_BALL_X_SPEED)
+	{
+		bool left = hit.normalX == 0 ? ball.xVelocity < 0 : hit.normalX < 0;
+		ball.xVelocity = left ? -MIN_BALL_X_SPEED : MIN_BALL_X_SPEED;
+	}
+}
+
+// Queue an event for the front end. A tick never comes close to the limit
+void GameWorld::emit(GameEventType type)
+{
+	if (eventCount < MAX_TICK_EVENTS)
+	{
+		events[eventCount].type = type;
+		events[eventCount].x = ball.x + ball.width / 2;
+		events[eventCount].y = ball.y + ball.height / 2;
+		events[eventCount].speed = sqrt(ball.xVelocity * ball.xVelocity + ball.yVelocity * ball.yVelocity);
+		eventCount++;
+	}
+}
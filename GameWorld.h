@@ -0,0 +1,203 @@
+#pragma once
+#include "Tennis.h"
+#include "AiPlanner.h"
+#include "Arena.h"
+#include "BallPool.h"
+
+// The game simulates at a fixed rate no matter how fast the display refreshes.
+// 60 is the rate the ball and paddle speeds were tuned at on vsynced displays
+const int TICKS_PER_SECOND = 60;
+
+// Score that wins a match
+const int WINNING_SCORE = 10;
+
+// How far player 1's paddle moves in a tick at full stick or with a key held. This matches holding
+// a key down under typical key repeat, when every repeat moved the paddle PADDLE_SPEED
+const double PLAYER1_SPEED = PADDLE_SPEED / 2;
+
+// Fastest the ball may go along either axis, in pixels a tick. Every hit speeds it up, and past this it
+// crosses the court in well under a second. The swept collisions would cope with any speed, but nobody
+// could return it
+const double MAX_BALL_SPEED = 24;
+
+// Slowest the ball may cross the court after a bumper, in pixels a tick. A round bumper hit near 45
+// degrees can turn a flat ball straight up or down, and it would then bounce between the walls forever
+const double MIN_BALL_X_SPEED = 2;
+
+// The difficulty curve. Each trick turns on once player 1's score is past its threshold
+struct DifficultyParams
+{
+	// After each of its hits, player 2 serves a zigzag with a 1 in zigzagOdds chance
+	int zigzagScore;
+	int zigzagOdds;
+
+	// A ball crossing the middle toward player 2 turns back with a 1 in reverseOdds chance each tick
+	int reverseScore;
+	int reverseOdds;
+
+	// Player 1's paddle shrinks and player 2's grows, once per match
+	int resizeScore;
+	double player1ResizeHeight;
+	double player2ResizeHeight;
+
+	// Player 2's paddle speed is PADDLE_SPEED divided by a slowdown, picked at each of its hits from
+	// aiSlowdownMin up to aiSlowdownMin + aiSlowdownRange - 1. A match starts at aiSlowdownMin
+	int aiSlowdownMin;
+	int aiSlowdownRange;
+
+	// Player 2's reaction delay and aim error
+	AiSkill aiSkill;
+};
+
+// The curve the game is played with. Player 2 starts at a seventh of PADDLE_SPEED: any faster and, with
+// the ball speed clamped, it returns nearly everything and matches stop ending
+const DifficultyParams DEFAULT_DIFFICULTY = { 2, 5, 5, 7, 7, 25, 60, 7, 5, DEFAULT_AI_SKILL };
+
+// States a match moves through. Enter advances start -> serve -> play, and done -> serve
+enum GameState
+{
+	STATE_START,
+	STATE_SERVE,
+	STATE_PLAY,
+	STATE_DONE
+};
+
+// Things that happened during a tick. The front end plays sounds and draws effects for them
+enum GameEventType
+{
+	EVENT_PLAYER1_HIT,
+	EVENT_PLAYER2_HIT,
+	EVENT_WALL_HIT,
+	EVENT_BUMPER_HIT,
+	EVENT_PLAYER1_SCORE,
+	EVENT_PLAYER2_SCORE,
+	EVENT_PLAYER1_WIN,
+	EVENT_PLAYER2_WIN,
+	EVENT_STATE_CHANGED
+};
+
+struct GameEvent
+{
+	GameEventType type;
+
+	// Centre of the ball and its speed in pixels a tick when it happened, for effects drawn at the spot
+	double x, y;
+	double speed;
+};
+
+// Player input consumed by one tick
+struct GameInputs
+{
+	// Enter was pressed
+	bool advance = false;
+
+	// Paddle controls, from -1 (full speed up) to 1 (full speed down). Player 2's is only used when a
+	// person plays it
+	double player1Axis = 0;
+	double player2Axis = 0;
+};
+
+// Player 1's axis is applied in steps of 1 / AXIS_STEPS, so a recorded match can store it in a byte
+// and still replay exactly
+const int AXIS_STEPS = 127;
+
+// Rounds an axis value to the nearest step, from -AXIS_STEPS to AXIS_STEPS
+int quantizeAxis(double axis);
+
+// Everything about a match that changes from tick to tick, saved so netplay can rewind to an earlier
+// tick and play it again. Chaos balls aren't included
+struct GameSnapshot
+{
+	uint64_t rngState;
+	double ballX, ballY, ballXVelocity, ballYVelocity;
+	double player1Y, player1Height;
+	double player2Y, player2Height, player2Speed;
+	double aiTargetY, aiAimOffset;
+	int aiWait;
+	AiReplan aiPending;
+	int player1Score, player2Score, winningPlayer;
+	GameState state;
+	int zigzagTot;
+	bool sevenFlag, zigzagFlag;
+};
+
+// Most events a single tick can emit
+const int MAX_TICK_EVENTS = 16;
+
+// Most paddle and wall bounces resolved inside one tick
+const int MAX_BALL_BOUNCES = 4;
+
+// GameWorld holds the whole match and all of its rules: movement, collisions, scoring and the
+// difficulty tricks. Player 2 is driven by an AiPlanner. It has no SDL dependency, so it can run headless
+class GameWorld
+{
+public:
+	// The seed decides every random choice in the match. The same seed and inputs always play the same match
+	GameWorld(uint64_t seed = 1, const DifficultyParams& difficulty = DEFAULT_DIFFICULTY);
+
+	// Advances the match by one tick. Events from the tick are left in events
+	void step(const GameInputs& inputs);
+
+	// Hash of the whole match state, used to check a replay ended where the recording did
+	uint64_t checksum() const;
+
+	// Saves or restores the match at the start of a tick
+	void save(GameSnapshot& snapshot) const;
+	void load(const GameSnapshot& snapshot);
+
+	// Random numbers for the ball, the difficulty tricks and the AI. Declared before the ball, which uses it
+	Rng rng;
+
+	// Paddles and ball
+	Paddle player1;
+	Paddle player2;
+	Ball ball;
+
+	// Player 2's AI, and the difficulty curve it plays to
+	AiPlanner ai;
+	DifficultyParams difficulty;
+
+	// Player 2 is moved by player2Axis instead of the AI, at player 1's speed
+	bool player2Human = false;
+
+	// Moves the ball and paddles in Q16.16 fixed point (Fixed.h) instead of doubles: the ball's sweep
+	// against the paddles and walls, the speed-ups and the paddles' moves. A match plays the same, bit for
+	// bit, on any compiler and CPU. Set it before the first step, and record and replay with the same setting
+	bool fixedPoint = false;
+
+	// Bumpers on the court, none unless a layout is loaded
+	Arena arena;
+
+	// Extra balls of chaos mode, empty unless spawned. They bounce off the paddles but never score
+	BallPool chaosBalls;
+
+	// Scores, who won the last match, and where the match is
+	int player1Score = 0;
+	int player2Score = 0;
+	int winningPlayer = 0;
+	GameState state = STATE_START;
+
+	// Flags and accumulator for random game events
+	bool sevenFlag = false;
+	bool zigzagFlag = false;
+	int zigzagTot = 0;
+
+	// Events emitted by the last step
+	GameEvent events[MAX_TICK_EVENTS];
+	int eventCount = 0;
+
+private:
+	void advance();
+	void movePaddle(Paddle& paddle, double axis);
+	void updatePlay();
+	void moveBall();
+	void moveBallFixed();
+	double speedUp(double velocity, double factor) const;
+	double randomSpin(bool negative);
+	double snap(double value) const;
+	void hitPlayer1();
+	void hitPlayer2();
+	void hitWall(int wall);
+	void hitBumper(const SweepHit& hit);
+	void emit(GameEventType type);
+};
@@ -0,0 +1,236 @@
+#include "GlyphAtlas.h"
+#include "RenderStats.h"
+#include "Trace.h"
+#include <stdio.h>
+
+// Gap left between packed glyphs so linear filtering never samples a neighbour
+const int ATLAS_PADDING = 1;
+
+GlyphAtlas::GlyphAtlas()
+{
+	mFaceCount = 0;
+	mSurface = NULL;
+	mTexture = NULL;
+}
+
+GlyphAtlas::~GlyphAtlas()
+{
+	free();
+}
+
+int GlyphAtlas::addFont(TTF_Font* font)
+{
+	if (mFaceCount == ATLAS_MAX_FACES || font == NULL)
+	{
+		return -1;
+	}
+
+	mFaces[mFaceCount].font = font;
+	mFaces[mFaceCount].height = TTF_FontHeight(font);
+	return mFaceCount++;
+}
+
+bool GlyphAtlas::build(SDL_Renderer* renderer, SDL_Color color)
+{
+	// Get rid of a previously built texture
+	free();
+	return rasterize(color) && upload(renderer);
+}
+
+bool GlyphAtlas::rasterize(SDL_Color color)
+{
+	TRACE_ZONE("rasterize glyphs");
+
+	// Get rid of glyphs that were never uploaded. The texture is left alone, since this may not be the render thread
+	if (mSurface != NULL)
+	{
+		SDL_FreeSurface(mSurface);
+		mSurface = NULL;
+	}
+
+	// Solid text takes its alpha from the palette, so make sure the glyphs come out opaque
+	color.a = 0xFF;
+
+	// Rasterize every glyph and lay them out left to right in rows
+	SDL_Surface* glyphSurfaces[ATLAS_MAX_FACES][ATLAS_GLYPH_COUNT] = {};
+	int penX = 0;
+	int penY = 0;
+	int rowHeight = 0;
+	for (int f = 0; f < mFaceCount; f++)
+	{
+		Face& face = mFaces[f];
+		for (int g = 0; g < ATLAS_GLYPH_COUNT; g++)
+		{
+			Uint16 ch = (Uint16)(ATLAS_FIRST_CHAR + g);
+			int minX, maxX, minY, maxY, advance;
+			SDL_Surface* glyphSurface = countSurface(TTF_RenderGlyph_Solid(face.font, ch, color));
+			if (TTF_GlyphMetrics(face.font, ch, &minX, &maxX, &minY, &maxY, &advance) == -1)
+			{
+				advance = glyphSurface != NULL ? glyphSurface->w : 0;
+			}
+			face.advances[g] = advance;
+
+			// Glyphs with no pixels (like the space) only move the pen
+			if (glyphSurface == NULL)
+			{
+				face.glyphs[g] = { 0, 0, 0, 0 };
+				continue;
+			}
+
+			// Start a new row when this one is full
+			if (penX + glyphSurface->w > ATLAS_WIDTH)
+			{
+				penX = 0;
+				penY += rowHeight + ATLAS_PADDING;
+				rowHeight = 0;
+			}
+			face.glyphs[g] = { penX, penY, glyphSurface->w, glyphSurface->h };
+			glyphSurfaces[f][g] = glyphSurface;
+			penX += glyphSurface->w + ATLAS_PADDING;
+			if (glyphSurface->h > rowHeight)
+			{
+				rowHeight = glyphSurface->h;
+			}
+		}
+	}
+
+	// Copy the glyphs into one transparent surface. Solid glyphs are color keyed, so only their pixels land
+	bool success = true;
+	mSurface = countSurface(SDL_CreateRGBSurfaceWithFormat(0, ATLAS_WIDTH, penY + rowHeight, 32, SDL_PIXELFORMAT_RGBA32));
+	if (mSurface == NULL)
+	{
+		printf("Unable to create glyph atlas surface! SDL Error: %s\n", SDL_GetError());
+		success = false;
+	}
+	else
+	{
+		SDL_FillRect(mSurface, NULL, SDL_MapRGBA(mSurface->format, 0, 0, 0, 0));
+		for (int f = 0; f < mFaceCount; f++)
+		{
+			for (int g = 0; g < ATLAS_GLYPH_COUNT; g++)
+			{
+				if (glyphSurfaces[f][g] != NULL)
+				{
+					SDL_Rect dest = mFaces[f].glyphs[g];
+					SDL_BlitSurface(glyphSurfaces[f][g], NULL, mSurface, &dest);
+				}
+			}
+		}
+	}
+
+	// Get rid of the glyph surfaces
+	for (int f = 0; f < mFaceCount; f++)
+	{
+		for (int g = 0; g < ATLAS_GLYPH_COUNT; g++)
+		{
+			SDL_FreeSurface(glyphSurfaces[f][g]);
+		}
+	}
+
+	return success;
+}
+
+bool GlyphAtlas::upload(SDL_Renderer* renderer)
+{
+	TRACE_ZONE("upload glyphs");
+
+	if (mSurface == NULL)
+	{
+		return false;
+	}
+
+	// Replace any texture from an earlier upload. The surface isn't needed after this
+	if (mTexture != NULL)
+	{
+		SDL_DestroyTexture(mTexture);
+	}
+	bool success = true;
+	mTexture = createTexture(renderer, mSurface);
+	if (mTexture == NULL)
+	{
+		printf("Unable to create glyph atlas texture! SDL Error: %s\n", SDL_GetError());
+		success = false;
+	}
+	else
+	{
+		SDL_SetTextureBlendMode(mTexture, SDL_BLENDMODE_BLEND);
+	}
+
+	SDL_FreeSurface(mSurface);
+	mSurface = NULL;
+	return success;
+}
+
+bool GlyphAtlas::isReady()
+{
+	return mTexture != NULL;
+}
+
+void GlyphAtlas::free()
+{
+	if (mSurface != NULL)
+	{
+		SDL_FreeSurface(mSurface);
+		mSurface = NULL;
+	}
+	if (mTexture != NULL)
+	{
+		SDL_DestroyTexture(mTexture);
+		mTexture = NULL;
+	}
+}
+
+void GlyphAtlas::render(RenderQueue& queue, int face, const char* text, int x, int y)
+{
+	if (mTexture == NULL || face < 0 || face >= mFaceCount)
+	{
+		return;
+	}
+
+	// Queue a copy of each glyph. They all share the atlas texture, so the whole string is one batch
+	const SDL_Color white = { 0xFF, 0xFF, 0xFF, 0xFF };
+	const Face& f = mFaces[face];
+	for (const char* c = text; *c != '\0'; c++)
+	{
+		int g = (unsigned char)*c - ATLAS_FIRST_CHAR;
+		if (g < 0 || g >= ATLAS_GLYPH_COUNT)
+		{
+			continue;
+		}
+
+		if (f.glyphs[g].w > 0)
+		{
+			SDL_Rect dest = { x, y, f.glyphs[g].w, f.glyphs[g].h };
+			queue.addQuad(mTexture, f.glyphs[g], dest, white);
+		}
+		x += f.advances[g];
+	}
+}
+
+int GlyphAtlas::getTextWidth(int face, const char* text)
+{
+	if (face < 0 || face >= mFaceCount)
+	{
+		return 0;
+	}
+
+	int width = 0;
+	for (const char* c = text; *c != '\0'; c++)
+	{
+		int g = (unsigned char)*c - ATLAS_FIRST_CHAR;
+		if (g >= 0 && g < ATLAS_GLYPH_COUNT)
+		{
+			width += mFaces[face].advances[g];
+		}
+	}
+	return width;
+}
+
+int GlyphAtlas::getHeight(int face)
+{
+	if (face < 0 || face >= mFaceCount)
+	{
+		return 0;
+	}
+	return mFaces[face].height;
+}
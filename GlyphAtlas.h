@@ -0,0 +1,65 @@
+#pragma once
+#include <SDL.h>
+#include <SDL_ttf.h>
+#include "RenderQueue.h"
+
+// Printable ASCII range baked into the atlas
+const int ATLAS_FIRST_CHAR = 32;
+const int ATLAS_LAST_CHAR = 126;
+const int ATLAS_GLYPH_COUNT = ATLAS_LAST_CHAR - ATLAS_FIRST_CHAR + 1;
+
+// Fonts (one per size) an atlas can hold, and the width glyph rows are packed into
+const int ATLAS_MAX_FACES = 4;
+const int ATLAS_WIDTH = 1024;
+
+// GlyphAtlas rasterizes every glyph of several font sizes once into a single texture.
+// Strings are then drawn as sub-rect copies of that texture, so changing text never creates a texture
+class GlyphAtlas
+{
+public:
+	GlyphAtlas();
+	~GlyphAtlas();
+
+	// Registers a font size to bake. Returns the face index used for drawing, or -1 if the atlas is full
+	int addFont(TTF_Font* font);
+
+	// Rasterizes all registered faces in the given color and uploads them as one texture
+	bool build(SDL_Renderer* renderer, SDL_Color color);
+
+	// The two halves of build. rasterize only touches the fonts and memory, so it can run on a loader
+	// thread. upload creates the texture and has to run on the render thread
+	bool rasterize(SDL_Color color);
+	bool upload(SDL_Renderer* renderer);
+
+	// True once the texture is uploaded. Until then nothing is drawn
+	bool isReady();
+
+	// Deallocates the texture. Registered faces are kept so the atlas can be rebuilt
+	void free();
+
+	// Queues text with its top left corner at x, y
+	void render(RenderQueue& queue, int face, const char* text, int x, int y);
+
+	// Gets the dimensions a string would have if drawn
+	int getTextWidth(int face, const char* text);
+	int getHeight(int face);
+
+private:
+	// Where each glyph of one font size lives in the texture, and how far it moves the pen
+	struct Face
+	{
+		TTF_Font* font;
+		int height;
+		SDL_Rect glyphs[ATLAS_GLYPH_COUNT];
+		int advances[ATLAS_GLYPH_COUNT];
+	};
+
+	Face mFaces[ATLAS_MAX_FACES];
+	int mFaceCount;
+
+	// Rasterized glyphs waiting to be uploaded
+	SDL_Surface* mSurface;
+
+	// The texture every face is packed into
+	SDL_Texture* mTexture;
+};
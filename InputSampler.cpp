@@ -0,0 +1,101 @@
+#include "InputSampler.h"
+#include <stdio.h>
+
+InputSampler::InputSampler()
+{
+	mController = NULL;
+}
+
+InputSampler::~InputSampler()
+{
+	free();
+}
+
+void InputSampler::handleEvent(const SDL_Event& event)
+{
+	// Use the first controller that shows up. SDL sends an added event for controllers already plugged in at startup
+	if (event.type == SDL_CONTROLLERDEVICEADDED && mController == NULL)
+	{
+		mController = SDL_GameControllerOpen(event.cdevice.which);
+		if (mController == NULL)
+		{
+			printf("Unable to open game controller! SDL Error: %s\n", SDL_GetError());
+		}
+	}
+	else if (event.type == SDL_CONTROLLERDEVICEREMOVED && mController != NULL
+		&& SDL_GameControllerFromInstanceID(event.cdevice.which) == mController)
+	{
+		free();
+	}
+}
+
+double InputSampler::samplePlayer1Axis()
+{
+	// Held keys give full speed
+	const Uint8* keys = SDL_GetKeyboardState(NULL);
+	int keyAxis = 0;
+	if (keys[SDL_SCANCODE_S] || keys[SDL_SCANCODE_DOWN])
+	{
+		keyAxis++;
+	}
+	if (keys[SDL_SCANCODE_W] || keys[SDL_SCANCODE_UP])
+	{
+		keyAxis--;
+	}
+	if (keyAxis != 0 || mController == NULL)
+	{
+		return keyAxis;
+	}
+
+	// Then the d-pad
+	if (SDL_GameControllerGetButton(mController, SDL_CONTROLLER_BUTTON_DPAD_DOWN))
+	{
+		return 1;
+	}
+	if (SDL_GameControllerGetButton(mController, SDL_CONTROLLER_BUTTON_DPAD_UP))
+	{
+		return -1;
+	}
+
+	// Then the stick, scaled so speed starts from zero at the edge of the deadzone
+	int stick = SDL_GameControllerGetAxis(mController, SDL_CONTROLLER_AXIS_LEFTY);
+	if (stick > -STICK_DEADZONE && stick < STICK_DEADZONE)
+	{
+		return 0;
+	}
+	double travel = stick > 0 ? stick - STICK_DEADZONE : stick + STICK_DEADZONE;
+	return travel / (32767 - STICK_DEADZONE);
+}
+
+bool InputSampler::isAdvanceButton(const SDL_Event& event)
+{
+	return event.type == SDL_CONTROLLERBUTTONDOWN
+		&& (event.cbutton.button == SDL_CONTROLLER_BUTTON_A || event.cbutton.button == SDL_CONTROLLER_BUTTON_START);
+}
+
+bool InputSampler::isPaddleInput(const SDL_Event& event)
+{
+	if (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP)
+	{
+		SDL_Keycode key = event.key.keysym.sym;
+		return !event.key.repeat && (key == SDLK_w || key == SDLK_s || key == SDLK_UP || key == SDLK_DOWN);
+	}
+	if (event.type == SDL_CONTROLLERBUTTONDOWN || event.type == SDL_CONTROLLERBUTTONUP)
+	{
+		return event.cbutton.button == SDL_CONTROLLER_BUTTON_DPAD_UP || event.cbutton.button == SDL_CONTROLLER_BUTTON_DPAD_DOWN;
+	}
+	if (event.type == SDL_CONTROLLERAXISMOTION)
+	{
+		return event.caxis.axis == SDL_CONTROLLER_AXIS_LEFTY && (event.caxis.value >= STICK_DEADZONE || event.caxis.value <= -STICK_DEADZONE);
+	}
+	return false;
+}
+
+void InputSampler::free()
+{
+	if (mController != NULL)
+	{
+		SDL_GameControllerClose(mController);
+		mController = NULL;
+	}
+}
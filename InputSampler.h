@@ -0,0 +1,33 @@
+#pragma once
+#include <SDL.h>
+
+// Stick travel ignored around the centre, out of 32767, so a resting stick doesn't creep
+const int STICK_DEADZONE = 8000;
+
+// InputSampler reads player 1's controls as a held state rather than key presses, so the paddle moves
+// smoothly from the first tick a key is down instead of waiting on key repeat. It merges the keyboard
+// (W/S or the arrow keys) with the first connected game controller (left stick or d-pad)
+class InputSampler
+{
+public:
+	InputSampler();
+	~InputSampler();
+
+	// Opens a controller when one is plugged in and closes it when it is removed
+	void handleEvent(const SDL_Event& event);
+
+	// Player 1's paddle control from -1 (up) to 1 (down). Keys win over the stick
+	double samplePlayer1Axis();
+
+	// True if the event is a controller button that starts or serves (A or Start)
+	bool isAdvanceButton(const SDL_Event& event);
+
+	// True if the event changes player 1's paddle control: a key or d-pad press or release, or the stick outside the deadzone
+	bool isPaddleInput(const SDL_Event& event);
+
+	// Closes the controller
+	void free();
+
+private:
+	SDL_GameController* mController;
+};
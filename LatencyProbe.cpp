@@ -0,0 +1,83 @@
+#include "LatencyProbe.h"
+#include <stdio.h>
+
+void LatencyStat::add(double ms)
+{
+	count++;
+	total += ms;
+	if (ms > max)
+	{
+		max = ms;
+	}
+}
+
+double LatencyStat::average()
+{
+	return count > 0 ? total / count : 0;
+}
+
+LatencyProbe::LatencyProbe()
+{
+	mInputTime = 0;
+	mTickTime = 0;
+	mSequence = 0;
+}
+
+void LatencyProbe::inputArrived(Uint32 eventTimestamp)
+{
+	// Only follow one input at a time. Later inputs would be consumed by the same tick anyway
+	if (mInputTime != 0)
+	{
+		return;
+	}
+
+	// Event timestamps are in milliseconds. Back the high resolution clock up by however long the event sat in the queue
+	Uint64 now = SDL_GetPerformanceCounter();
+	Uint32 queued = SDL_GetTicks() - eventTimestamp;
+	mInputTime = now - queued * SDL_GetPerformanceFrequency() / 1000;
+}
+
+void LatencyProbe::inputSent(Uint32 sequence)
+{
+	if (mInputTime != 0 && mSequence == 0)
+	{
+		mSequence = sequence;
+	}
+}
+
+void LatencyProbe::tickConsumed(Uint32 sequence, Uint64 time)
+{
+	// Frames ticked before the control was handed over don't show the input yet. The difference is
+	// signed so the numbers can wrap
+	if (mSequence != 0 && mTickTime == 0 && (Sint32)(sequence - mSequence) >= 0)
+	{
+		mTickTime = time;
+		inputToTick.add(toMilliseconds(mTickTime > mInputTime ? mTickTime - mInputTime : 0));
+	}
+}
+
+void LatencyProbe::presented()
+{
+	if (mTickTime != 0)
+	{
+		Uint64 now = SDL_GetPerformanceCounter();
+		tickToPresent.add(toMilliseconds(now - mTickTime));
+		inputToPresent.add(toMilliseconds(now - mInputTime));
+		mInputTime = 0;
+		mTickTime = 0;
+		mSequence = 0;
+	}
+}
+
+void LatencyProbe::printReport()
+{
+	printf("Input latency over %d inputs (average / worst):\n", inputToPresent.count);
+	printf("  input to tick:    %.2f / %.2f ms\n", inputToTick.average(), inputToTick.max);
+	printf("  tick to present:  %.2f / %.2f ms\n", tickToPresent.average(), tickToPresent.max);
+	printf("  input to present: %.2f / %.2f ms\n", inputToPresent.average(), inputToPresent.max);
+}
+
+double LatencyProbe::toMilliseconds(Uint64 counts)
+{
+	return counts * 1000.0 / SDL_GetPerformanceFrequency();
+}
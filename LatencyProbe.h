@@ -0,0 +1,53 @@
+#pragma once
+#include <SDL.h>
+
+// One leg of the input to screen path, in milliseconds
+struct LatencyStat
+{
+	int count = 0;
+	double total = 0;
+	double max = 0;
+
+	void add(double ms);
+	double average();
+};
+
+// LatencyProbe follows paddle inputs through the game loop. It timestamps when the input reached SDL,
+// the sim tick that consumed it and the SDL_RenderPresent that showed the result. The sim thread reads
+// the controls on its own schedule, so the tick is matched by the number of the control handed to it
+class LatencyProbe
+{
+public:
+	LatencyProbe();
+
+	// An input arrived. eventTimestamp is the SDL event's timestamp, which accounts for time spent queued
+	void inputArrived(Uint32 eventTimestamp);
+
+	// The input state was handed to the sim thread as control number sequence
+	void inputSent(Uint32 sequence);
+
+	// A frame arrived whose tick read control number sequence at time, on the sim thread's clock. Only a
+	// tick that read the control carrying the input counts
+	void tickConsumed(Uint32 sequence, Uint64 time);
+
+	// A frame was presented
+	void presented();
+
+	// Time from input to tick, tick to present, and the whole path
+	LatencyStat inputToTick;
+	LatencyStat tickToPresent;
+	LatencyStat inputToPresent;
+
+	// Prints averages and worst cases
+	void printReport();
+
+private:
+	double toMilliseconds(Uint64 counts);
+
+	// Input waiting for a tick, then for a present. 0 when nothing is in flight
+	Uint64 mInputTime;
+	Uint64 mTickTime;
+
+	// Number of the control carrying the input, 0 until it has been handed over
+	Uint32 mSequence;
+};
@@ -0,0 +1,242 @@
+#include "NetSession.h"
+#include "Trace.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+
+using namespace std;
+
+// Packets start with these two bytes, then the packet type
+const uint8_t NET_MAGIC0 = 'B';
+const uint8_t NET_MAGIC1 = 'T';
+const uint8_t NET_PACKET_HELLO = 1;
+const uint8_t NET_PACKET_INPUTS = 2;
+
+// Little endian fields, so both ends agree whatever they run on
+static void writeU32(uint8_t* out, uint32_t value)
+{
+	for (int i = 0; i < 4; i++)
+	{
+		out[i] = (uint8_t)(value >> (i * 8));
+	}
+}
+
+static uint32_t readU32(const uint8_t* in)
+{
+	uint32_t value = 0;
+	for (int i = 0; i < 4; i++)
+	{
+		value |= (uint32_t)in[i] << (i * 8);
+	}
+	return value;
+}
+
+NetSession::NetSession(int localPlayer)
+{
+	mLocalPlayer = localPlayer;
+	mTick = 0;
+	mRemoteTick = 0;
+	mAckedTick = 0;
+	mRollbackFrom = -1;
+	memset(mLocalInputs, 0, sizeof(mLocalInputs));
+	memset(mRemoteInputs, 0, sizeof(mRemoteInputs));
+
+	rollbacks = 0;
+	replayedTicks = 0;
+	maxRollbackDepth = 0;
+	replaySeconds = 0;
+	maxReplaySeconds = 0;
+	stalls = 0;
+}
+
+bool NetSession::canAdvance() const
+{
+	return mTick - mRemoteTick < NET_ROLLBACK_TICKS;
+}
+
+bool NetSession::advance(GameWorld& world, double localAxis, bool localAdvance)
+{
+	rollback(world);
+	if (!canAdvance())
+	{
+		stalls++;
+		return false;
+	}
+
+	NetInput& local = mLocalInputs[mTick % NET_HISTORY_TICKS];
+	local.axis = (int8_t)quantizeAxis(localAxis);
+	local.advance = localAdvance;
+
+	world.save(mSnapshots[mTick % NET_HISTORY_TICKS]);
+	world.step(inputsFor(mTick));
+	mTick++;
+	return true;
+}
+
+void NetSession::rollback(GameWorld& world)
+{
+	if (mRollbackFrom == -1)
+	{
+		return;
+	}
+
+	// Go back to before the first tick that was played with a wrong guess, and play up to now again
+	TRACE_ZONE("rollback");
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	world.load(mSnapshots[mRollbackFrom % NET_HISTORY_TICKS]);
+	for (int tick = mRollbackFrom; tick < mTick; tick++)
+	{
+		if (tick > mRollbackFrom)
+		{
+			world.save(mSnapshots[tick % NET_HISTORY_TICKS]);
+		}
+		world.step(inputsFor(tick));
+	}
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	int depth = mTick - mRollbackFrom;
+	rollbacks++;
+	replayedTicks += depth;
+	maxRollbackDepth = max(maxRollbackDepth, depth);
+	replaySeconds += seconds;
+	maxReplaySeconds = max(maxReplaySeconds, seconds);
+	mRollbackFrom = -1;
+}
+
+GameInputs NetSession::inputsFor(int tick)
+{
+	// A remote input that hasn't arrived is guessed to be the last one that did, without an Enter press
+	NetInput& remote = mRemoteInputs[tick % NET_HISTORY_TICKS];
+	if (tick >= mRemoteTick)
+	{
+		remote.axis = mRemoteTick > 0 ? mRemoteInputs[(mRemoteTick - 1) % NET_HISTORY_TICKS].axis : 0;
+		remote.advance = 0;
+	}
+	const NetInput& local = mLocalInputs[tick % NET_HISTORY_TICKS];
+
+	GameInputs inputs;
+	inputs.advance = local.advance || remote.advance;
+	double localAxis = (double)local.axis / AXIS_STEPS;
+	double remoteAxis = (double)remote.axis / AXIS_STEPS;
+	inputs.player1Axis = mLocalPlayer == 1 ? localAxis : remoteAxis;
+	inputs.player2Axis = mLocalPlayer == 1 ? remoteAxis : localAxis;
+	return inputs;
+}
+
+int NetSession::writeInputs(uint8_t* packet) const
+{
+	int count = min(mTick - mAckedTick, NET_HISTORY_TICKS);
+	packet[0] = NET_MAGIC0;
+	packet[1] = NET_MAGIC1;
+	packet[2] = NET_PACKET_INPUTS;
+	writeU32(packet + 3, (uint32_t)(mTick - count));
+	writeU32(packet + 7, (uint32_t)mRemoteTick);
+	packet[11] = (uint8_t)count;
+
+	uint8_t* out = packet + 12;
+	for (int tick = mTick - count; tick < mTick; tick++)
+	{
+		const NetInput& input = mLocalInputs[tick % NET_HISTORY_TICKS];
+		*out++ = (uint8_t)input.axis;
+		*out++ = input.advance;
+	}
+	return (int)(out - packet);
+}
+
+void NetSession::readInputs(const uint8_t* packet, int size)
+{
+	if (size < 12 || packet[0] != NET_MAGIC0 || packet[1] != NET_MAGIC1 || packet[2] != NET_PACKET_INPUTS
+		|| size < 12 + packet[11] * 2)
+	{
+		return;
+	}
+
+	// Packets can arrive late or out of order, so the acknowledgement only ever moves forward
+	int first = (int)readU32(packet + 3);
+	int acked = (int)readU32(packet + 7);
+	int count = packet[11];
+	mAckedTick = max(mAckedTick, min(acked, mTick));
+
+	// Take the inputs that carry on from the last one received. Earlier ones are repeats
+	const uint8_t* in = packet + 12;
+	for (int tick = first; tick < first + count; tick++, in += 2)
+	{
+		if (tick != mRemoteTick || tick - mTick >= NET_ROLLBACK_TICKS)
+		{
+			continue;
+		}
+
+		NetInput input = { (int8_t)in[0], (uint8_t)(in[1] != 0) };
+		NetInput& stored = mRemoteInputs[tick % NET_HISTORY_TICKS];
+		if (tick < mTick && (input.axis != stored.axis || input.advance != stored.advance)
+			&& (mRollbackFrom == -1 || tick < mRollbackFrom))
+		{
+			mRollbackFrom = tick;
+		}
+		stored = input;
+		mRemoteTick++;
+	}
+}
+
+int NetSession::writeHello(uint8_t* packet, const NetHello& hello)
+{
+	packet[0] = NET_MAGIC0;
+	packet[1] = NET_MAGIC1;
+	packet[2] = NET_PACKET_HELLO;
+	writeU32(packet + 3, (uint32_t)hello.seed);
+	writeU32(packet + 7, (uint32_t)(hello.seed >> 32));
+	packet[11] = hello.fixedPoint ? 1 : 0;
+	writeU32(packet + 12, (uint32_t)hello.arenaHash);
+	writeU32(packet + 16, (uint32_t)(hello.arenaHash >> 32));
+	return 20;
+}
+
+bool NetSession::readHello(const uint8_t* packet, int size, NetHello& hello)
+{
+	if (size < 20 || packet[0] != NET_MAGIC0 || packet[1] != NET_MAGIC1 || packet[2] != NET_PACKET_HELLO)
+	{
+		return false;
+	}
+	hello.seed = readU32(packet + 3) | (uint64_t)readU32(packet + 7) << 32;
+	hello.fixedPoint = packet[11] != 0;
+	hello.arenaHash = readU32(packet + 12) | (uint64_t)readU32(packet + 16) << 32;
+	return true;
+}
+
+bool NetSession::helloAgrees(const NetHello& local, const NetHello& remote)
+{
+	bool agrees = true;
+	if (local.fixedPoint != remote.fixedPoint)
+	{
+		printf("The other side plays %s -fixed, and this one %s. Both have to agree\n",
+			remote.fixedPoint ? "with" : "without", local.fixedPoint ? "with" : "without");
+		agrees = false;
+	}
+	if (local.arenaHash != remote.arenaHash)
+	{
+		printf("The other side plays a different arena. Both have to load the same -arena\n");
+		agrees = false;
+	}
+	return agrees;
+}
+
+int NetSession::getTick() const
+{
+	return mTick;
+}
+
+int NetSession::getRemoteTick() const
+{
+	return mRemoteTick;
+}
+
+void NetSession::printReport() const
+{
+	printf("Netplay ticks: %d\n", mTick);
+	printf("Rollbacks: %lld, %.2f ticks replayed per tick played, deepest %d ticks\n", rollbacks,
+		mTick > 0 ? (double)replayedTicks / mTick : 0, maxRollbackDepth);
+	printf("Replay cost: %.2fus a tick played, %.1fus a rollback on average, %.1fus at most\n",
+		mTick > 0 ? replaySeconds * 1e6 / mTick : 0, rollbacks > 0 ? replaySeconds * 1e6 / rollbacks : 0, maxReplaySeconds * 1e6);
+	printf("Ticks spent waiting for the other side: %lld\n", stalls);
+}
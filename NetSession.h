@@ -0,0 +1,100 @@
+#pragma once
+#include <stdint.h>
+#include "GameWorld.h"
+
+// Ticks a side may play past the last input it has from the other side, predicting the rest. Half a
+// second covers any connection worth playing over. Past it the side waits
+const int NET_ROLLBACK_TICKS = 30;
+
+// Ticks of inputs and snapshots kept. A side can be at most two windows ahead of what the other has
+// acknowledged, so this leaves plenty of room
+const int NET_HISTORY_TICKS = 128;
+
+// Largest packet either side sends
+const int NET_MAX_PACKET = 16 + NET_HISTORY_TICKS * 2;
+
+// One player's input for a tick, as it goes over the network
+struct NetInput
+{
+	int8_t axis;
+	uint8_t advance;
+};
+
+// What the two sides agree on before a match: the host's seed, and the settings that change how a match
+// plays out. Matches with different -fixed or -arena settings would drift apart straight away
+struct NetHello
+{
+	uint64_t seed;
+	bool fixedPoint;
+	uint64_t arenaHash;
+};
+
+// NetSession runs one side of a two player match with rollback. Every tick it plays the local input
+// straight away with a prediction of the remote one (whatever the remote player last held), and keeps a
+// snapshot of the match from before the tick. When the real remote input for a tick turns out different
+// from the prediction, the match is rewound to that tick's snapshot and played forward again with the
+// inputs as they really were. Packets carry every input the other side hasn't acknowledged yet, so a
+// lost packet is covered by the next one. The session only makes and reads packets; sending them is up
+// to the caller
+class NetSession
+{
+public:
+	// localPlayer is 1 or 2. The other player is the remote one
+	NetSession(int localPlayer);
+
+	// False when the remote side is so far behind that this one has to wait for it
+	bool canAdvance() const;
+
+	// Rewinds and replays if a late input changed the past, then plays the next tick. Returns false,
+	// playing nothing, when it has to wait
+	bool advance(GameWorld& world, double localAxis, bool localAdvance);
+
+	// Only the rewind and replay. Done at the start of advance
+	void rollback(GameWorld& world);
+
+	// Packet with every local input the remote side hasn't acknowledged, and the acknowledgement of
+	// the remote inputs received so far. Returns its size
+	int writeInputs(uint8_t* packet) const;
+
+	// Takes in the inputs from a remote packet. Anything that isn't an input packet is ignored
+	void readInputs(const uint8_t* packet, int size);
+
+	// Handshake packets: the joining side sends a hello with its settings, and the host answers with the
+	// match seed and its own
+	static int writeHello(uint8_t* packet, const NetHello& hello);
+	static bool readHello(const uint8_t* packet, int size, NetHello& hello);
+
+	// True when the remote side plays with the same settings as this one. Prints what differs when not
+	static bool helloAgrees(const NetHello& local, const NetHello& remote);
+
+	// Next tick to play, and how many ticks of remote input have arrived
+	int getTick() const;
+	int getRemoteTick() const;
+
+	// Rollback statistics, printed on exit
+	void printReport() const;
+	long long rollbacks;
+	long long replayedTicks;
+	int maxRollbackDepth;
+	double replaySeconds;
+	double maxReplaySeconds;
+	long long stalls;
+
+private:
+	// Both players' inputs for a tick. Remote input that hasn't arrived is predicted and remembered
+	GameInputs inputsFor(int tick);
+
+	int mLocalPlayer;
+
+	// Next tick to play, remote ticks received, local ticks the remote side has, and the earliest tick
+	// that has to be played again (-1 for none)
+	int mTick;
+	int mRemoteTick;
+	int mAckedTick;
+	int mRollbackFrom;
+
+	// Rings indexed by tick
+	NetInput mLocalInputs[NET_HISTORY_TICKS];
+	NetInput mRemoteInputs[NET_HISTORY_TICKS];
+	GameSnapshot mSnapshots[NET_HISTORY_TICKS];
+};
@@ -0,0 +1,28 @@
+#pragma once
+#include <stdint.h>
+
+// Asset packs start with "BTPK" and a format version
+const uint32_t PACK_MAGIC = 0x4B505442;
+const uint32_t PACK_VERSION = 1;
+
+// Longest asset name, including the terminating zero
+const int PACK_NAME_LENGTH = 48;
+
+// Asset data starts on this boundary so samples and font tables are aligned in memory
+const int PACK_ALIGNMENT = 16;
+
+// A pack is laid out as
+//   header:  magic, version, asset count (u32 each)
+//   index:   one PackEntry per asset
+//   data:    each asset at its offset from the start of the file
+// All numbers are little endian
+struct PackEntry
+{
+	char name[PACK_NAME_LENGTH];
+	uint32_t offset;
+	uint32_t size;
+};
+
+// Size of the header and of one index entry in the file
+const int PACK_HEADER_SIZE = 12;
+const int PACK_ENTRY_SIZE = PACK_NAME_LENGTH + 8;
@@ -0,0 +1,212 @@
+#include "ParticlePool.h"
+#include "Trace.h"
+#include <math.h>
+
+// Share of their speed particles lose a second
+const float PARTICLE_DRAG = 3;
+
+// Sparks for the paddles, walls and bumpers, and the score burst
+const SDL_Color HIT_SPARK_COLOR = { 0xFF, 0xC8, 0x50, 0xFF };
+const SDL_Color WALL_SPARK_COLOR = { 0x80, 0xC0, 0xFF, 0xFF };
+const SDL_Color SCORE_BURST_COLOR = { 0xFF, 0xFF, 0xFF, 0xFF };
+const int SCORE_BURST_PARTICLES = 160;
+
+// The trail drops a particle every few pixels the ball travels, up to a limit a frame
+const float TRAIL_SPACING = 3;
+const int TRAIL_MAX_PER_FRAME = 32;
+
+const float PI = 3.14159265f;
+
+ParticlePool::ParticlePool() : mRng(0x5EED, 3)
+{
+	mX.resize(PARTICLE_CAPACITY);
+	mY.resize(PARTICLE_CAPACITY);
+	mXVelocity.resize(PARTICLE_CAPACITY);
+	mYVelocity.resize(PARTICLE_CAPACITY);
+	mLife.resize(PARTICLE_CAPACITY);
+	mFade.resize(PARTICLE_CAPACITY);
+	mSize.resize(PARTICLE_CAPACITY);
+	mColor.resize(PARTICLE_CAPACITY);
+	mCount = 0;
+	mSpawned = 0;
+	mDropped = 0;
+}
+
+void ParticlePool::addEffect(const GameEvent& event)
+{
+	float x = fminf(fmaxf((float)event.x, 0), (float)SCREEN_WIDTH);
+	float y = fminf(fmaxf((float)event.y, 0), (float)SCREEN_HEIGHT);
+
+	// Faster balls throw more sparks further
+	int count = 8 + (int)(event.speed * 2);
+	float speed = (float)event.speed * TICKS_PER_SECOND;
+
+	switch (event.type)
+	{
+	case EVENT_PLAYER1_HIT:
+		sparks(x, y, count, 0, 1, speed, 0.35f, HIT_SPARK_COLOR);
+		break;
+	case EVENT_PLAYER2_HIT:
+		sparks(x, y, count, PI, 1, speed, 0.35f, HIT_SPARK_COLOR);
+		break;
+	case EVENT_WALL_HIT:
+		sparks(x, y, count / 2, y < SCREEN_HEIGHT / 2 ? PI / 2 : -PI / 2, 1.2f, speed, 0.25f, WALL_SPARK_COLOR);
+		break;
+	case EVENT_BUMPER_HIT:
+		sparks(x, y, count / 2, 0, PI, speed, 0.25f, WALL_SPARK_COLOR);
+		break;
+	case EVENT_PLAYER1_SCORE:
+	case EVENT_PLAYER2_SCORE:
+		sparks(x, y, SCORE_BURST_PARTICLES, 0, PI, 300 + speed / 2, 0.9f, SCORE_BURST_COLOR);
+		break;
+	default:
+		break;
+	}
+}
+
+void ParticlePool::addTrail(float fromX, float fromY, float toX, float toY, float speed)
+{
+	float dx = toX - fromX;
+	float dy = toY - fromY;
+	int count = (int)(sqrtf(dx * dx + dy * dy) / TRAIL_SPACING) + 1;
+	count = count < TRAIL_MAX_PER_FRAME ? count : TRAIL_MAX_PER_FRAME;
+
+	Uint8 level = (Uint8)fminf(0x40 + speed * 8, 0xFF);
+	SDL_Color color = { level, level, level, 0xFF };
+	float lifetime = 0.1f + speed * 0.01f;
+	float size = 3 + speed / 8;
+	for (int i = 0; i < count; i++)
+	{
+		float along = (float)i / count;
+		if (!spawn(fromX + dx * along, fromY + dy * along, random(-20, 20), random(-20, 20), lifetime, size, color))
+		{
+			mDropped += count - i - 1;
+			return;
+		}
+	}
+}
+
+void ParticlePool::update(float seconds)
+{
+	TRACE_ZONE("particles");
+	float drag = seconds * PARTICLE_DRAG < 1 ? 1 - seconds * PARTICLE_DRAG : 0;
+
+	// One pass over the arrays with no branches, which the compiler turns into SIMD
+	float* x = mX.data();
+	float* y = mY.data();
+	float* xVelocity = mXVelocity.data();
+	float* yVelocity = mYVelocity.data();
+	float* life = mLife.data();
+	int count = mCount;
+	for (int i = 0; i < count; i++)
+	{
+		x[i] += xVelocity[i] * seconds;
+		y[i] += yVelocity[i] * seconds;
+		xVelocity[i] *= drag;
+		yVelocity[i] *= drag;
+		life[i] -= seconds;
+	}
+
+	// A faded particle is replaced by the last live one, so the live ones stay packed at the front
+	for (int i = 0; i < mCount;)
+	{
+		if (life[i] > 0)
+		{
+			i++;
+			continue;
+		}
+		int last = --mCount;
+		x[i] = x[last];
+		y[i] = y[last];
+		xVelocity[i] = xVelocity[last];
+		yVelocity[i] = yVelocity[last];
+		life[i] = life[last];
+		mFade[i] = mFade[last];
+		mSize[i] = mSize[last];
+		mColor[i] = mColor[last];
+	}
+
+	mSpawned = 0;
+}
+
+void ParticlePool::render(RenderQueue& queue)
+{
+	if (mCount == 0)
+	{
+		return;
+	}
+
+	// Additive, so overlapping sparks glow and fading ones dim to nothing
+	SDL_Vertex* vertex = queue.addQuads(mCount, LAYER_OBJECTS, SDL_BLENDMODE_ADD);
+	for (int i = 0; i < mCount; i++, vertex += 4)
+	{
+		float half = mSize[i] / 2;
+		float left = mX[i] - half;
+		float top = mY[i] - half;
+		float right = mX[i] + half;
+		float bottom = mY[i] + half;
+		SDL_Color color = mColor[i];
+		color.a = (Uint8)(mLife[i] * mFade[i] * 0xFF);
+		vertex[0] = { { left, top }, color, { 0, 0 } };
+		vertex[1] = { { right, top }, color, { 0, 0 } };
+		vertex[2] = { { right, bottom }, color, { 0, 0 } };
+		vertex[3] = { { left, bottom }, color, { 0, 0 } };
+	}
+}
+
+void ParticlePool::clear()
+{
+	mCount = 0;
+}
+
+int ParticlePool::getCount() const
+{
+	return mCount;
+}
+
+long long ParticlePool::getDropped() const
+{
+	return mDropped;
+}
+
+bool ParticlePool::spawn(float x, float y, float xVelocity, float yVelocity, float lifetime, float size, SDL_Color color)
+{
+	if (mCount == PARTICLE_CAPACITY || mSpawned == PARTICLE_SPAWN_BUDGET)
+	{
+		mDropped++;
+		return false;
+	}
+
+	int i = mCount++;
+	mX[i] = x;
+	mY[i] = y;
+	mXVelocity[i] = xVelocity;
+	mYVelocity[i] = yVelocity;
+	mLife[i] = lifetime;
+	mFade[i] = 1 / lifetime;
+	mSize[i] = size;
+	mColor[i] = color;
+	mSpawned++;
+	return true;
+}
+
+void ParticlePool::sparks(float x, float y, int count, float angle, float spread, float speed, float lifetime, SDL_Color color)
+{
+	for (int i = 0; i < count; i++)
+	{
+		float direction = angle + random(-spread, spread);
+		float velocity = speed * random(0.3f, 1);
+		if (!spawn(x, y, cosf(direction) * velocity, sinf(direction) * velocity, lifetime * random(0.5f, 1), random(2, 4), color))
+		{
+			// The rest would be dropped too
+			mDropped += count - i - 1;
+			return;
+		}
+	}
+}
+
+// Uniform in [low, high), from the top 24 bits so every value is exact in a float
+float ParticlePool::random(float low, float high)
+{
+	return low + (high - low) * (mRng.next() >> 8) * (1.0f / 16777216);
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <SDL.h>
+#include <vector>
+#include "GameWorld.h"
+#include "RenderQueue.h"
+#include "Rng.h"
+
+// Particles alive at once, and particles that may be spawned in one frame. Past either limit new ones
+// are dropped, so an effect can get dense but a frame's particle work never grows past the capacity
+const int PARTICLE_CAPACITY = 4096;
+const int PARTICLE_SPAWN_BUDGET = 512;
+
+// ParticlePool draws the sparks, ball trail and score bursts. Particles are kept as one array per field,
+// allocated once, and every frame they are moved in plain loops over the arrays that the compiler
+// vectorizes. All of them are drawn as one additive batch. They only decorate the front end, so they use
+// their own random numbers and frame time and never touch the match
+class ParticlePool
+{
+public:
+	ParticlePool();
+
+	// Sparks for a hit and a burst for a score, at the ball and scaled by its speed
+	void addEffect(const GameEvent& event);
+
+	// Lays a trail along the ball's path since the last frame. The faster the ball, the longer the trail lasts
+	// and the brighter it is
+	void addTrail(float fromX, float fromY, float toX, float toY, float speed);
+
+	// Moves every particle on by seconds and removes the ones that have faded out. Starts a new spawn budget
+	void update(float seconds);
+
+	// Queues every particle as one batch
+	void render(RenderQueue& queue);
+
+	// Removes every particle
+	void clear();
+
+	int getCount() const;
+
+	// Particles not spawned because the pool or the frame's budget was full
+	long long getDropped() const;
+
+private:
+	// Adds one particle. Returns false if it was dropped
+	bool spawn(float x, float y, float xVelocity, float yVelocity, float lifetime, float size, SDL_Color color);
+
+	// count particles flying out from (x, y) within spread radians either side of angle
+	void sparks(float x, float y, int count, float angle, float spread, float speed, float lifetime, SDL_Color color);
+
+	float random(float low, float high);
+
+	// Particle state, one entry per particle in each array. Only the first mCount are alive
+	std::vector<float> mX, mY, mXVelocity, mYVelocity;
+	std::vector<float> mLife, mFade, mSize;
+	std::vector<SDL_Color> mColor;
+	int mCount;
+
+	int mSpawned;
+	long long mDropped;
+	Rng mRng;
+};
@@ -0,0 +1,278 @@
+#include "PerfHud.h"
+#include <stdio.h>
+#include <algorithm>
+
+// Short names for the phases, used on screen and in the summary
+static const char* PHASE_NAMES[PHASE_COUNT] = { "events", "sim", "text", "render", "present" };
+
+// Overlay layout
+const int HUD_X = 8;
+const int HUD_Y = 8;
+const int HUD_WIDTH = 640;
+const int HUD_BAR_WIDTH = 8;
+const int HUD_GRAPH_HEIGHT = 60;
+const SDL_Color HUD_PANEL_COLOR = { 0x00, 0x00, 0x00, 0xC0 };
+const SDL_Color HUD_BAR_COLOR = { 0x40, 0xC0, 0x40, 0xFF };
+const SDL_Color HUD_MISS_COLOR = { 0xE0, 0x40, 0x40, 0xFF };
+
+PerfHud::PerfHud()
+{
+	mVisible = false;
+	mVsyncMs = 1000.0 / 60;
+	mFrameStart = 0;
+	mLastMark = 0;
+	mTraceFrameStart = 0;
+	mTraceLastMark = 0;
+	mHistoryCount = 0;
+	mHistoryNext = 0;
+	mLastTextures = 0;
+	mLastDrawCalls = 0;
+	mLastAllocations = 0;
+	mFrames = 0;
+	mMissedVsync = 0;
+	mFrameMaxMs = 0;
+	mTexturesTotal = 0;
+	mDrawCallsTotal = 0;
+	mDrawCallsMax = 0;
+	mAllocationsTotal = 0;
+	mAllocationsMax = 0;
+	for (int i = 0; i < PHASE_COUNT; i++)
+	{
+		mPhaseMs[i] = 0;
+		mLastPhaseMs[i] = 0;
+		mPhaseTotalMs[i] = 0;
+		mPhaseMaxMs[i] = 0;
+	}
+	for (int i = 0; i < HUD_HISTORY; i++)
+	{
+		mFrameMs[i] = 0;
+	}
+	for (int i = 0; i < HUD_SESSION_BUCKETS; i++)
+	{
+		mSessionBuckets[i] = 0;
+	}
+}
+
+void PerfHud::init(SDL_Window* window)
+{
+	SDL_DisplayMode mode;
+	if (SDL_GetWindowDisplayMode(window, &mode) == 0 && mode.refresh_rate > 0)
+	{
+		mVsyncMs = 1000.0 / mode.refresh_rate;
+	}
+}
+
+void PerfHud::toggle()
+{
+	mVisible = !mVisible;
+}
+
+bool PerfHud::isVisible()
+{
+	return mVisible;
+}
+
+void PerfHud::beginFrame()
+{
+	mFrameStart = SDL_GetPerformanceCounter();
+	mLastMark = mFrameStart;
+#ifdef TRACE_ENABLED
+	mTraceFrameStart = traceNow();
+	mTraceLastMark = mTraceFrameStart;
+#endif
+	for (int i = 0; i < PHASE_COUNT; i++)
+	{
+		mPhaseMs[i] = 0;
+	}
+}
+
+void PerfHud::mark(PerfPhase phase)
+{
+	Uint64 now = SDL_GetPerformanceCounter();
+	mPhaseMs[phase] += toMilliseconds(now - mLastMark);
+	mLastMark = now;
+
+	// Every phase is a zone in the trace too
+#ifdef TRACE_ENABLED
+	int64_t traceTime = traceNow();
+	traceRecord(PHASE_NAMES[phase], mTraceLastMark, traceTime);
+	mTraceLastMark = traceTime;
+#endif
+}
+
+void PerfHud::endFrame(int texturesCreated, int drawCalls, int allocations)
+{
+#ifdef TRACE_ENABLED
+	traceRecord("frame", mTraceFrameStart, traceNow());
+#endif
+	double frameMs = toMilliseconds(SDL_GetPerformanceCounter() - mFrameStart);
+
+	// Rolling history
+	mFrameMs[mHistoryNext] = frameMs;
+	mHistoryNext = (mHistoryNext + 1) % HUD_HISTORY;
+	if (mHistoryCount < HUD_HISTORY)
+	{
+		mHistoryCount++;
+	}
+	for (int i = 0; i < PHASE_COUNT; i++)
+	{
+		mLastPhaseMs[i] = mPhaseMs[i];
+	}
+	mLastTextures = texturesCreated;
+	mLastDrawCalls = drawCalls;
+	mLastAllocations = allocations;
+
+	// Session totals. A frame more than half a refresh late missed at least one vsync
+	mFrames++;
+	if (frameMs > mVsyncMs * 1.5)
+	{
+		mMissedVsync++;
+	}
+	for (int i = 0; i < PHASE_COUNT; i++)
+	{
+		mPhaseTotalMs[i] += mPhaseMs[i];
+		if (mPhaseMs[i] > mPhaseMaxMs[i])
+		{
+			mPhaseMaxMs[i] = mPhaseMs[i];
+		}
+	}
+	int bucket = (int)(frameMs * 10);
+	mSessionBuckets[bucket < HUD_SESSION_BUCKETS ? bucket : HUD_SESSION_BUCKETS - 1]++;
+	if (frameMs > mFrameMaxMs)
+	{
+		mFrameMaxMs = frameMs;
+	}
+	mTexturesTotal += texturesCreated;
+	mDrawCallsTotal += drawCalls;
+	if (drawCalls > mDrawCallsMax)
+	{
+		mDrawCallsMax = drawCalls;
+	}
+	mAllocationsTotal += allocations;
+	if (allocations > mAllocationsMax)
+	{
+		mAllocationsMax = allocations;
+	}
+}
+
+void PerfHud::render(RenderQueue& queue, GlyphAtlas& atlas, int face)
+{
+	// Text can't be drawn until the fonts have loaded
+	if (!mVisible || !atlas.isReady())
+	{
+		return;
+	}
+
+	char line[96];
+	int lineHeight = atlas.getHeight(face);
+
+	// Backing panel so the numbers stay readable over the court
+	SDL_Rect panel = { HUD_X, HUD_Y, HUD_WIDTH, lineHeight * 3 + HUD_GRAPH_HEIGHT + 24 };
+	queue.addRect(panel, HUD_PANEL_COLOR, LAYER_OVERLAY, SDL_BLENDMODE_BLEND);
+
+	// Frame time over the rolling window
+	double maxMs = 0;
+	for (int i = 0; i < mHistoryCount; i++)
+	{
+		maxMs = mFrameMs[i] > maxMs ? mFrameMs[i] : maxMs;
+	}
+	snprintf(line, sizeof(line), "frame %.2f p50 %.2f p99 %.2f max %.2f",
+		mFrameMs[(mHistoryNext + HUD_HISTORY - 1) % HUD_HISTORY], historyPercentile(0.5), historyPercentile(0.99), maxMs);
+	atlas.render(queue, face, line, HUD_X + 8, HUD_Y + 4);
+
+	// Last frame's phases
+	snprintf(line, sizeof(line), "ev %.2f sim %.2f txt %.2f rnd %.2f pr %.2f",
+		mLastPhaseMs[PHASE_EVENTS], mLastPhaseMs[PHASE_SIM], mLastPhaseMs[PHASE_TEXT], mLastPhaseMs[PHASE_RENDER], mLastPhaseMs[PHASE_PRESENT]);
+	atlas.render(queue, face, line, HUD_X + 8, HUD_Y + 4 + lineHeight);
+
+	// Counters
+	snprintf(line, sizeof(line), "missed vsync %d  textures %d  draws %d  allocs %d", mMissedVsync, mLastTextures, mLastDrawCalls, mLastAllocations);
+	atlas.render(queue, face, line, HUD_X + 8, HUD_Y + 4 + lineHeight * 2);
+
+	// Histogram of the rolling window in 1ms buckets. Buckets past a refresh interval are frames that missed vsync
+	int buckets[HUD_BUCKETS] = {};
+	int tallest = 1;
+	for (int i = 0; i < mHistoryCount; i++)
+	{
+		int bucket = (int)mFrameMs[i];
+		bucket = bucket < HUD_BUCKETS ? bucket : HUD_BUCKETS - 1;
+		buckets[bucket]++;
+		tallest = buckets[bucket] > tallest ? buckets[bucket] : tallest;
+	}
+	int graphBottom = HUD_Y + 12 + lineHeight * 3 + HUD_GRAPH_HEIGHT;
+	for (int i = 0; i < HUD_BUCKETS; i++)
+	{
+		int height = buckets[i] * HUD_GRAPH_HEIGHT / tallest;
+		if (buckets[i] > 0 && height == 0)
+		{
+			height = 1;
+		}
+		SDL_Rect bar = { HUD_X + 8 + i * HUD_BAR_WIDTH, graphBottom - height, HUD_BAR_WIDTH - 1, height };
+		queue.addRect(bar, i + 1 > mVsyncMs * 1.5 ? HUD_MISS_COLOR : HUD_BAR_COLOR, LAYER_OVERLAY);
+	}
+}
+
+bool PerfHud::writeSummary(const char* path)
+{
+	FILE* file = fopen(path, "w");
+	if (file == NULL)
+	{
+		printf("Unable to write performance summary to %s!\n", path);
+		return false;
+	}
+
+	fprintf(file, "metric,value\n");
+	fprintf(file, "frames,%d\n", mFrames);
+	fprintf(file, "vsync_ms,%.3f\n", mVsyncMs);
+	fprintf(file, "missed_vsync,%d\n", mMissedVsync);
+	fprintf(file, "frame_p50_ms,%.3f\n", sessionPercentile(0.5));
+	fprintf(file, "frame_p99_ms,%.3f\n", sessionPercentile(0.99));
+	fprintf(file, "frame_max_ms,%.3f\n", mFrameMaxMs);
+	for (int i = 0; i < PHASE_COUNT; i++)
+	{
+		fprintf(file, "%s_avg_ms,%.4f\n", PHASE_NAMES[i], mFrames > 0 ? mPhaseTotalMs[i] / mFrames : 0);
+		fprintf(file, "%s_max_ms,%.4f\n", PHASE_NAMES[i], mPhaseMaxMs[i]);
+	}
+	fprintf(file, "textures_created,%lld\n", mTexturesTotal);
+	fprintf(file, "draw_calls_avg,%.2f\n", mFrames > 0 ? (double)mDrawCallsTotal / mFrames : 0);
+	fprintf(file, "draw_calls_max,%d\n", mDrawCallsMax);
+	fprintf(file, "allocations_avg,%.2f\n", mFrames > 0 ? (double)mAllocationsTotal / mFrames : 0);
+	fprintf(file, "allocations_max,%d\n", mAllocationsMax);
+
+	fclose(file);
+	return true;
+}
+
+double PerfHud::toMilliseconds(Uint64 counts)
+{
+	return counts * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+double PerfHud::historyPercentile(double fraction)
+{
+	if (mHistoryCount == 0)
+	{
+		return 0;
+	}
+
+	double sorted[HUD_HISTORY];
+	std::copy(mFrameMs, mFrameMs + mHistoryCount, sorted);
+	std::sort(sorted, sorted + mHistoryCount);
+	return sorted[(int)(fraction * (mHistoryCount - 1))];
+}
+
+double PerfHud::sessionPercentile(double fraction)
+{
+	// Walk the buckets until enough frames are covered, and report the middle of that bucket
+	int target = (int)(fraction * mFrames);
+	int covered = 0;
+	for (int i = 0; i < HUD_SESSION_BUCKETS; i++)
+	{
+		covered += mSessionBuckets[i];
+		if (covered > target)
+		{
+			return (i + 0.5) / 10;
+		}
+	}
+	return mFrameMaxMs;
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <SDL.h>
+#include "GlyphAtlas.h"
+#include "RenderQueue.h"
+#include "Trace.h"
+
+// Parts of a frame the HUD times, in the order the main loop runs them
+enum PerfPhase
+{
+	PHASE_EVENTS,
+	PHASE_SIM,
+	PHASE_TEXT,
+	PHASE_RENDER,
+	PHASE_PRESENT,
+	PHASE_COUNT
+};
+
+// Frames kept for the rolling view, and the 1ms buckets the histogram shows
+const int HUD_HISTORY = 240;
+const int HUD_BUCKETS = 34;
+
+// Session wide frame time distribution, in 0.1ms steps up to 100ms, for the exit summary
+const int HUD_SESSION_BUCKETS = 1000;
+
+// PerfHud times the phases of every frame and keeps a rolling frame time history. It can draw itself
+// over the game and writes a CSV summary of the whole session on exit
+class PerfHud
+{
+public:
+	PerfHud();
+
+	// Reads the display's refresh rate so frames that miss vsync can be counted
+	void init(SDL_Window* window);
+
+	// Shows or hides the overlay. Timing runs either way
+	void toggle();
+	bool isVisible();
+
+	// Starts timing a frame
+	void beginFrame();
+
+	// Ends the current phase, charging the time since the previous mark to it
+	void mark(PerfPhase phase);
+
+	// Finishes the frame with the textures created, draw calls made and heap allocations during it
+	void endFrame(int texturesCreated, int drawCalls, int allocations);
+
+	// Queues the overlay: phase times, the frame time histogram with p50/p99/max and the counters
+	void render(RenderQueue& queue, GlyphAtlas& atlas, int face);
+
+	// Writes the session summary. Returns false if the file couldn't be opened
+	bool writeSummary(const char* path);
+
+private:
+	double toMilliseconds(Uint64 counts);
+
+	// Percentile of the rolling history, in ms
+	double historyPercentile(double fraction);
+
+	// Percentile of the whole session, in ms
+	double sessionPercentile(double fraction);
+
+	bool mVisible;
+	double mVsyncMs;
+
+	// Current frame
+	Uint64 mFrameStart;
+	Uint64 mLastMark;
+
+	// The same frame and phase boundaries on the trace clock, when tracing is compiled in
+	int64_t mTraceFrameStart;
+	int64_t mTraceLastMark;
+	double mPhaseMs[PHASE_COUNT];
+
+	// Rolling history
+	double mFrameMs[HUD_HISTORY];
+	double mLastPhaseMs[PHASE_COUNT];
+	int mHistoryCount;
+	int mHistoryNext;
+	int mLastTextures;
+	int mLastDrawCalls;
+	int mLastAllocations;
+
+	// Session totals
+	int mFrames;
+	int mMissedVsync;
+	double mPhaseTotalMs[PHASE_COUNT];
+	double mPhaseMaxMs[PHASE_COUNT];
+	int mSessionBuckets[HUD_SESSION_BUCKETS];
+	double mFrameMaxMs;
+	long long mTexturesTotal;
+	long long mDrawCallsTotal;
+	int mDrawCallsMax;
+	long long mAllocationsTotal;
+	int mAllocationsMax;
+};
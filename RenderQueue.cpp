@@ -0,0 +1,188 @@
+#include "RenderQueue.h"
+#include "RenderStats.h"
+#include <algorithm>
+
+// Items a frame normally holds. Buffers grow past this if needed and then stay grown
+const int RENDER_QUEUE_RESERVE = 512;
+
+RenderQueue::RenderQueue()
+{
+	mCommands.reserve(RENDER_QUEUE_RESERVE);
+	mVertices.reserve(RENDER_QUEUE_RESERVE * 4);
+	mIndices.reserve(RENDER_QUEUE_RESERVE * 6);
+}
+
+void RenderQueue::addRect(const SDL_Rect& rect, SDL_Color color, int layer, SDL_BlendMode blending)
+{
+	Command command = { layer, blending, NULL, (int)mCommands.size(), { 0, 0, 0, 0 }, rect, color, 0, 0 };
+	mCommands.push_back(command);
+}
+
+void RenderQueue::addQuad(SDL_Texture* texture, const SDL_Rect& src, const SDL_Rect& dst, SDL_Color color, int layer, SDL_BlendMode blending)
+{
+	Command command = { layer, blending, texture, (int)mCommands.size(), src, dst, color, 0, 0 };
+	mCommands.push_back(command);
+}
+
+void RenderQueue::addRects(const float* x, const float* y, int count, float width, float height, SDL_Color color, int layer, SDL_BlendMode blending)
+{
+	if (count <= 0)
+	{
+		return;
+	}
+
+	// Build the corners now, straight from the arrays. flush only has to copy them
+	int first = (int)mRectVertices.size();
+	mRectVertices.resize(first + count * 4);
+	SDL_Vertex* vertex = &mRectVertices[first];
+	for (int i = 0; i < count; i++, vertex += 4)
+	{
+		float right = x[i] + width;
+		float bottom = y[i] + height;
+		vertex[0] = { { x[i], y[i] }, color, { 0, 0 } };
+		vertex[1] = { { right, y[i] }, color, { 0, 0 } };
+		vertex[2] = { { right, bottom }, color, { 0, 0 } };
+		vertex[3] = { { x[i], bottom }, color, { 0, 0 } };
+	}
+
+	Command command = { layer, blending, NULL, (int)mCommands.size(), { 0, 0, 0, 0 }, { 0, 0, 0, 0 }, color, first, count };
+	mCommands.push_back(command);
+}
+
+SDL_Vertex* RenderQueue::addQuads(int count, int layer, SDL_BlendMode blending)
+{
+	int first = (int)mRectVertices.size();
+	mRectVertices.resize(first + count * 4);
+	SDL_Color white = { 0xFF, 0xFF, 0xFF, 0xFF };
+	Command command = { layer, blending, NULL, (int)mCommands.size(), { 0, 0, 0, 0 }, { 0, 0, 0, 0 }, white, first, count };
+	mCommands.push_back(command);
+	return &mRectVertices[first];
+}
+
+void RenderQueue::reserve(int quads)
+{
+	mRectVertices.reserve(mRectVertices.capacity() + quads * 4);
+	mVertices.reserve(mVertices.capacity() + quads * 4);
+	mIndices.reserve(mIndices.capacity() + quads * 6);
+}
+
+int RenderQueue::flush(SDL_Renderer* renderer)
+{
+	// Order by layer, then by state so commands that can share a draw call end up adjacent. Queue order breaks ties
+	std::sort(mCommands.begin(), mCommands.end(), [](const Command& a, const Command& b)
+	{
+		if (a.layer != b.layer)
+		{
+			return a.layer < b.layer;
+		}
+		if (a.blending != b.blending)
+		{
+			return a.blending < b.blending;
+		}
+		if (a.texture != b.texture)
+		{
+			return a.texture < b.texture;
+		}
+		return a.order < b.order;
+	});
+
+	// Submit each run of commands with the same layer, blend mode and texture as one geometry call
+	int drawCalls = 0;
+	size_t first = 0;
+	while (first < mCommands.size())
+	{
+		const Command& batch = mCommands[first];
+		int textureWidth = 1;
+		int textureHeight = 1;
+		if (batch.texture != NULL)
+		{
+			SDL_QueryTexture(batch.texture, NULL, NULL, &textureWidth, &textureHeight);
+		}
+
+		mVertices.clear();
+		mIndices.clear();
+		size_t last = first;
+		while (last < mCommands.size() && mCommands[last].layer == batch.layer
+			&& mCommands[last].blending == batch.blending && mCommands[last].texture == batch.texture)
+		{
+			if (mCommands[last].rectCount > 0)
+			{
+				appendRects(mCommands[last]);
+			}
+			else
+			{
+				appendQuad(mCommands[last], (float)textureWidth, (float)textureHeight);
+			}
+			last++;
+		}
+
+		// Untextured geometry uses the renderer's blend mode, textured geometry the texture's
+		if (batch.texture == NULL)
+		{
+			SDL_SetRenderDrawBlendMode(renderer, batch.blending);
+		}
+		else
+		{
+			SDL_SetTextureBlendMode(batch.texture, batch.blending);
+		}
+		SDL_RenderGeometry(renderer, batch.texture, &mVertices[0], (int)mVertices.size(), &mIndices[0], (int)mIndices.size());
+		drawCalls++;
+
+		first = last;
+	}
+
+	mCommands.clear();
+	mRectVertices.clear();
+	renderStats.drawCalls += drawCalls;
+	return drawCalls;
+}
+
+int RenderQueue::getSize()
+{
+	return (int)mCommands.size();
+}
+
+void RenderQueue::appendQuad(const Command& command, float textureWidth, float textureHeight)
+{
+	int base = (int)mVertices.size();
+	float left = (float)command.dst.x;
+	float top = (float)command.dst.y;
+	float right = (float)(command.dst.x + command.dst.w);
+	float bottom = (float)(command.dst.y + command.dst.h);
+
+	// Texture coordinates are normalized. Untextured quads ignore them
+	float u0 = command.src.x / textureWidth;
+	float v0 = command.src.y / textureHeight;
+	float u1 = (command.src.x + command.src.w) / textureWidth;
+	float v1 = (command.src.y + command.src.h) / textureHeight;
+
+	SDL_Vertex corners[4] = {
+		{ { left, top }, command.color, { u0, v0 } },
+		{ { right, top }, command.color, { u1, v0 } },
+		{ { right, bottom }, command.color, { u1, v1 } },
+		{ { left, bottom }, command.color, { u0, v1 } }
+	};
+	mVertices.insert(mVertices.end(), corners, corners + 4);
+
+	int indices[6] = { base, base + 1, base + 2, base, base + 2, base + 3 };
+	mIndices.insert(mIndices.end(), indices, indices + 6);
+}
+
+void RenderQueue::appendRects(const Command& command)
+{
+	int base = (int)mVertices.size();
+	const SDL_Vertex* first = &mRectVertices[command.rectFirst];
+	mVertices.insert(mVertices.end(), first, first + command.rectCount * 4);
+
+	size_t index = mIndices.size();
+	mIndices.resize(index + command.rectCount * 6);
+	for (int i = 0; i < command.rectCount; i++, base += 4, index += 6)
+	{
+		mIndices[index] = base;
+		mIndices[index + 1] = base + 1;
+		mIndices[index + 2] = base + 2;
+		mIndices[index + 3] = base;
+		mIndices[index + 4] = base + 2;
+		mIndices[index + 5] = base + 3;
+	}
+}
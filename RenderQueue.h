@@ -0,0 +1,70 @@
+#pragma once
+#include <SDL.h>
+#include <vector>
+
+// Draw order groups. Items in a lower layer are drawn first; inside a layer items are grouped freely
+const int LAYER_BACKGROUND = 0;
+const int LAYER_TEXT = 1;
+const int LAYER_OBJECTS = 2;
+const int LAYER_OVERLAY = 3;
+
+// RenderQueue collects every rectangle and textured quad drawn in a frame, then sorts them by layer,
+// blend mode and texture and submits each group as one SDL_RenderGeometry call
+class RenderQueue
+{
+public:
+	RenderQueue();
+
+	// Queues a solid rectangle
+	void addRect(const SDL_Rect& rect, SDL_Color color, int layer = LAYER_OBJECTS, SDL_BlendMode blending = SDL_BLENDMODE_NONE);
+
+	// Queues a copy of the src part of a texture to dst, tinted by color
+	void addQuad(SDL_Texture* texture, const SDL_Rect& src, const SDL_Rect& dst, SDL_Color color, int layer = LAYER_TEXT, SDL_BlendMode blending = SDL_BLENDMODE_BLEND);
+
+	// Queues count solid rectangles of one size and color with their top left corners at x[i], y[i].
+	// However many there are they take one slot in the queue, so thousands of them cost no sorting
+	void addRects(const float* x, const float* y, int count, float width, float height, SDL_Color color, int layer = LAYER_OBJECTS, SDL_BlendMode blending = SDL_BLENDMODE_NONE);
+
+	// Queues count quads with their own corners and colors, such as particles, and returns their 4 * count
+	// vertices for the caller to fill in. Like addRects they take one slot in the queue. The vertices are
+	// only good until the next add or flush
+	SDL_Vertex* addQuads(int count, int layer = LAYER_OBJECTS, SDL_BlendMode blending = SDL_BLENDMODE_BLEND);
+
+	// Makes room for this many quads on top of the usual, so a frame that suddenly draws that many more
+	// doesn't allocate
+	void reserve(int quads);
+
+	// Submits everything queued and empties the queue. Returns the number of draw calls made
+	int flush(SDL_Renderer* renderer);
+
+	// Items waiting for the next flush
+	int getSize();
+
+private:
+	struct Command
+	{
+		int layer;
+		SDL_BlendMode blending;
+		SDL_Texture* texture;
+		int order;
+		SDL_Rect src;
+		SDL_Rect dst;
+		SDL_Color color;
+
+		// Rectangles from addRects: where their vertices start in mRectVertices, and how many rectangles
+		int rectFirst;
+		int rectCount;
+	};
+
+	// Appends the two triangles for one command to the vertex and index buffers
+	void appendQuad(const Command& command, float textureWidth, float textureHeight);
+
+	// Appends the prebuilt rectangles of an addRects command
+	void appendRects(const Command& command);
+
+	// Storage is kept between frames, so a steady frame doesn't allocate
+	std::vector<Command> mCommands;
+	std::vector<SDL_Vertex> mVertices;
+	std::vector<int> mIndices;
+	std::vector<SDL_Vertex> mRectVertices;
+};
@@ -0,0 +1,32 @@
+#include "RenderStats.h"
+
+RenderStats renderStats;
+
+SDL_Texture* createTexture(SDL_Renderer* renderer, SDL_Surface* surface)
+{
+	SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
+	if (texture != NULL)
+	{
+		renderStats.texturesCreated++;
+	}
+	return texture;
+}
+
+SDL_Texture* createTexture(SDL_Renderer* renderer, Uint32 format, int access, int w, int h)
+{
+	SDL_Texture* texture = SDL_CreateTexture(renderer, format, access, w, h);
+	if (texture != NULL)
+	{
+		renderStats.texturesCreated++;
+	}
+	return texture;
+}
+
+SDL_Surface* countSurface(SDL_Surface* surface)
+{
+	if (surface != NULL)
+	{
+		renderStats.surfacesCreated++;
+	}
+	return surface;
+}
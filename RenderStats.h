@@ -0,0 +1,26 @@
+#pragma once
+#include <SDL.h>
+
+// Counters for GPU resource churn. The game loop reads these to check that steady play creates no textures or surfaces
+struct RenderStats
+{
+	// Textures created since startup
+	int texturesCreated = 0;
+
+	// Surfaces made by SDL, SDL_image or SDL_ttf since startup
+	int surfacesCreated = 0;
+
+	// Draw calls submitted by RenderQueue since startup
+	int drawCalls = 0;
+};
+
+extern RenderStats renderStats;
+
+// Creates a texture from surface pixels and counts it in renderStats
+SDL_Texture* createTexture(SDL_Renderer* renderer, SDL_Surface* surface);
+
+// Creates a blank texture and counts it in renderStats
+SDL_Texture* createTexture(SDL_Renderer* renderer, Uint32 format, int access, int w, int h);
+
+// Counts a surface that was just made in renderStats, and passes it through
+SDL_Surface* countSurface(SDL_Surface* surface);
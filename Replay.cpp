@@ -0,0 +1,364 @@
+#include "Replay.h"
+#include <string.h>
+#include <chrono>
+
+// Writes value as size little endian bytes
+static void writeValue(FILE* file, uint64_t value, int size)
+{
+	for (int i = 0; i < size; i++)
+	{
+		fputc((int)((value >> (8 * i)) & 0xFF), file);
+	}
+}
+
+// Reads size little endian bytes at offset, moving offset past them. Returns false past the end of the data
+static bool readValue(const std::vector<unsigned char>& data, size_t& offset, int size, uint64_t& value)
+{
+	if (offset + size > data.size())
+	{
+		return false;
+	}
+
+	value = 0;
+	for (int i = 0; i < size; i++)
+	{
+		value |= (uint64_t)data[offset + i] << (8 * i);
+	}
+	offset += size;
+	return true;
+}
+
+ReplayRecorder::ReplayRecorder()
+{
+	mFile = NULL;
+	mRun.ticks = 0;
+	mRun.advance = false;
+	mRun.axis = 0;
+	mTicks = 0;
+}
+
+ReplayRecorder::~ReplayRecorder()
+{
+	if (mFile != NULL)
+	{
+		fclose(mFile);
+	}
+}
+
+bool ReplayRecorder::open(const char* path, uint64_t seed, const GameWorld& world)
+{
+	mFile = fopen(path, "wb");
+	if (mFile == NULL)
+	{
+		printf("Unable to create replay %s!\n", path);
+		return false;
+	}
+
+	writeValue(mFile, REPLAY_MAGIC, 4);
+	writeValue(mFile, REPLAY_VERSION, 4);
+	writeValue(mFile, seed, 8);
+	writeValue(mFile, world.fixedPoint ? REPLAY_FIXED_POINT : 0, 1);
+	writeValue(mFile, world.arena.bumpers.size(), 4);
+	for (size_t i = 0; i < world.arena.bumpers.size(); i++)
+	{
+		const Bumper& bumper = world.arena.bumpers[i];
+		uint64_t box[4];
+		memcpy(box, &bumper.box, sizeof(box));
+		writeValue(mFile, bumper.shape, 1);
+		for (int j = 0; j < 4; j++)
+		{
+			writeValue(mFile, box[j], 8);
+		}
+	}
+	mRun.ticks = 0;
+	mTicks = 0;
+	return true;
+}
+
+bool ReplayRecorder::isOpen()
+{
+	return mFile != NULL;
+}
+
+void ReplayRecorder::record(const GameInputs& inputs)
+{
+	if (mFile == NULL)
+	{
+		return;
+	}
+
+	// Extend the current run if nothing changed, otherwise write it out and start another
+	int axis = quantizeAxis(inputs.player1Axis);
+	if (mRun.ticks > 0 && (mRun.advance != inputs.advance || mRun.axis != axis || mRun.ticks == REPLAY_MAX_RUN))
+	{
+		writeRun();
+	}
+	if (mRun.ticks == 0)
+	{
+		mRun.advance = inputs.advance;
+		mRun.axis = axis;
+	}
+	mRun.ticks++;
+	mTicks++;
+}
+
+bool ReplayRecorder::close(const GameWorld& world)
+{
+	if (mFile == NULL)
+	{
+		return false;
+	}
+
+	if (mRun.ticks > 0)
+	{
+		writeRun();
+	}
+	writeValue(mFile, 0, 4);
+	writeValue(mFile, mTicks, 4);
+	writeValue(mFile, world.checksum(), 8);
+
+	bool written = ferror(mFile) == 0;
+	if (fclose(mFile) != 0)
+	{
+		written = false;
+	}
+	mFile = NULL;
+
+	if (!written)
+	{
+		printf("Unable to finish writing the replay!\n");
+	}
+	return written;
+}
+
+void ReplayRecorder::writeRun()
+{
+	writeValue(mFile, mRun.ticks, 2);
+	writeValue(mFile, mRun.advance ? 1 : 0, 1);
+	writeValue(mFile, (uint8_t)(int8_t)mRun.axis, 1);
+	mRun.ticks = 0;
+}
+
+ReplayPlayer::ReplayPlayer()
+{
+	seed = 0;
+	fixedPoint = false;
+	tickCount = 0;
+	checksum = 0;
+	mRunIndex = 0;
+	mRunTicksPlayed = 0;
+	mTicksPlayed = 0;
+}
+
+bool ReplayPlayer::open(const char* path)
+{
+	FILE* file = fopen(path, "rb");
+	if (file == NULL)
+	{
+		printf("Unable to open replay %s!\n", path);
+		return false;
+	}
+
+	// Replays are small, so read it all at once
+	std::vector<unsigned char> data;
+	unsigned char buffer[4096];
+	size_t read;
+	while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+	{
+		data.insert(data.end(), buffer, buffer + read);
+	}
+	fclose(file);
+
+	size_t offset = 0;
+	uint64_t magic, version;
+	if (!readValue(data, offset, 4, magic) || magic != REPLAY_MAGIC || !readValue(data, offset, 4, version))
+	{
+		printf("%s is not a replay!\n", path);
+		return false;
+	}
+	if (version != REPLAY_VERSION)
+	{
+		printf("Replay %s is format version %llu, but this build plays version %u. Matches play out differently between them, so it can't be replayed\n",
+			path, (unsigned long long)version, REPLAY_VERSION);
+		return false;
+	}
+	uint64_t flags, bumperCount;
+	if (!readValue(data, offset, 8, seed) || !readValue(data, offset, 1, flags) || !readValue(data, offset, 4, bumperCount))
+	{
+		printf("Replay %s is cut short!\n", path);
+		return false;
+	}
+	fixedPoint = (flags & REPLAY_FIXED_POINT) != 0;
+
+	// The recorded arena. Each bumper is 33 bytes, so a count the file can't hold is caught before reserving
+	bumpers.clear();
+	if (bumperCount > (data.size() - offset) / 33)
+	{
+		printf("Replay %s is cut short!\n", path);
+		return false;
+	}
+	bumpers.reserve((size_t)bumperCount);
+	for (uint64_t i = 0; i < bumperCount; i++)
+	{
+		uint64_t shape, box[4];
+		bool read = readValue(data, offset, 1, shape);
+		for (int j = 0; j < 4; j++)
+		{
+			read = read && readValue(data, offset, 8, box[j]);
+		}
+		if (!read || (shape != BUMPER_RECT && shape != BUMPER_CIRCLE))
+		{
+			printf("Replay %s has a damaged arena!\n", path);
+			return false;
+		}
+		Bumper bumper;
+		bumper.shape = (BumperShape)shape;
+		memcpy(&bumper.box, box, sizeof(box));
+		bumpers.push_back(bumper);
+	}
+
+	// Runs until the 0 tick footer marker
+	mRuns.clear();
+	uint64_t recordedTicks = 0;
+	while (true)
+	{
+		uint64_t ticks, advance, axis;
+		if (!readValue(data, offset, 2, ticks) || !readValue(data, offset, 1, advance) || !readValue(data, offset, 1, axis))
+		{
+			printf("Replay %s is cut short!\n", path);
+			return false;
+		}
+		if (ticks == 0)
+		{
+			break;
+		}
+
+		ReplayRun run;
+		run.ticks = (int)ticks;
+		run.advance = advance != 0;
+		run.axis = (int8_t)(uint8_t)axis;
+		mRuns.push_back(run);
+		recordedTicks += ticks;
+	}
+
+	uint64_t footerTicks;
+	if (!readValue(data, offset, 4, footerTicks) || !readValue(data, offset, 8, checksum) || footerTicks != recordedTicks)
+	{
+		printf("Replay %s has a damaged footer!\n", path);
+		return false;
+	}
+	tickCount = (uint32_t)footerTicks;
+
+	mRunIndex = 0;
+	mRunTicksPlayed = 0;
+	mTicksPlayed = 0;
+	return true;
+}
+
+bool ReplayPlayer::check(bool fixedPointAsked, const char* arenaPath)
+{
+	if (fixedPointAsked && !fixedPoint)
+	{
+		printf("The replay was recorded without -fixed, so it can't be played with it\n");
+		return false;
+	}
+	if (fixedPoint && !fixedPointAsked)
+	{
+		printf("The replay was recorded with -fixed, so it plays with fixed point physics\n");
+	}
+
+	if (arenaPath != NULL)
+	{
+		Arena asked;
+		Arena recorded;
+		recorded.bumpers = bumpers;
+		if (!asked.load(arenaPath))
+		{
+			return false;
+		}
+		if (asked.hash() != recorded.hash())
+		{
+			printf("The replay was recorded with a different arena than %s (%d bumpers, %d in the file)\n",
+				arenaPath, (int)bumpers.size(), (int)asked.bumpers.size());
+			return false;
+		}
+	}
+	else if (!bumpers.empty())
+	{
+		printf("The replay was recorded with an arena of %d bumpers, which it plays with\n", (int)bumpers.size());
+	}
+	return true;
+}
+
+void ReplayPlayer::setUp(GameWorld& world)
+{
+	world.fixedPoint = fixedPoint;
+	world.arena.clear();
+	for (size_t i = 0; i < bumpers.size(); i++)
+	{
+		world.arena.add(bumpers[i]);
+	}
+	world.arena.bake();
+}
+
+bool ReplayPlayer::next(GameInputs& inputs)
+{
+	if (isFinished())
+	{
+		return false;
+	}
+
+	const ReplayRun& run = mRuns[mRunIndex];
+	inputs.advance = run.advance;
+	inputs.player1Axis = (double)run.axis / AXIS_STEPS;
+
+	mTicksPlayed++;
+	mRunTicksPlayed++;
+	if (mRunTicksPlayed == run.ticks)
+	{
+		mRunIndex++;
+		mRunTicksPlayed = 0;
+	}
+	return true;
+}
+
+bool ReplayPlayer::isFinished()
+{
+	return mRunIndex >= mRuns.size();
+}
+
+bool ReplayPlayer::verify(const GameWorld& world)
+{
+	uint64_t actual = world.checksum();
+	if (mTicksPlayed != tickCount || actual != checksum)
+	{
+		printf("Replay diverged after %u of %u ticks: checksum %016llx, expected %016llx\n",
+			mTicksPlayed, tickCount, (unsigned long long)actual, (unsigned long long)checksum);
+		return false;
+	}
+
+	printf("Replay matched: %u ticks, checksum %016llx\n", tickCount, (unsigned long long)checksum);
+	return true;
+}
+
+bool playReplayHeadless(const char* path, bool fixedPoint, const char* arenaPath)
+{
+	ReplayPlayer replay;
+	if (!replay.open(path) || !replay.check(fixedPoint, arenaPath))
+	{
+		return false;
+	}
+
+	GameWorld world(replay.seed);
+	replay.setUp(world);
+	GameInputs inputs;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	while (replay.next(inputs))
+	{
+		world.step(inputs);
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	printf("Played %u ticks in %.3f seconds (%.0f ticks/sec)\n", replay.tickCount, seconds, seconds > 0 ? replay.tickCount / seconds : 0);
+	return replay.verify(world);
+}
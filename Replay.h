@@ -0,0 +1,103 @@
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+#include "GameWorld.h"
+
+// Replay files start with "BTRP" and a format version. The version also goes up whenever the game rules
+// change how a recorded match plays out, so older recordings are turned away instead of failing to verify.
+// 2: player 2 is driven by AiPlanner
+// 3: the header holds the fixed point flag and the arena
+// 4: the ball leaves a bumper at MIN_BALL_X_SPEED or more across the court
+// 5: player 2's slowest paddle speed is a seventh of PADDLE_SPEED
+const uint32_t REPLAY_MAGIC = 0x50525442;
+const uint32_t REPLAY_VERSION = 5;
+
+// Header flags
+const uint32_t REPLAY_FIXED_POINT = 1;
+
+// Longest run of identical ticks one record can hold
+const int REPLAY_MAX_RUN = 65535;
+
+// A run of ticks that all had the same inputs. Paddle input rarely changes from one tick to the next,
+// so a match of tens of thousands of ticks is usually a few kilobytes
+struct ReplayRun
+{
+	int ticks;
+	bool advance;
+	int axis;
+};
+
+// ReplayRecorder writes the seed, the settings that change how the match plays and every tick's inputs to
+// a file. The file is laid out as
+//   header:  magic, version, seed (u64), flags (u8), bumper count (u32)
+//   bumpers: shape (u8), then x, y, width and height as the bits of doubles (u64 each)
+//   runs:    tick count (u16), advance (u8), axis step (i8)
+//   footer:  a run of 0 ticks, then the total ticks (u32) and the world checksum (u64)
+// All numbers are little endian
+class ReplayRecorder
+{
+public:
+	ReplayRecorder();
+	~ReplayRecorder();
+
+	// Starts a recording of a match created with seed. The fixed point flag and the arena are taken from
+	// world, which has to be set up already. Returns false if the file couldn't be created
+	bool open(const char* path, uint64_t seed, const GameWorld& world);
+	bool isOpen();
+
+	// Adds the inputs of the tick about to be stepped
+	void record(const GameInputs& inputs);
+
+	// Writes the footer with the world's final checksum and closes the file
+	bool close(const GameWorld& world);
+
+private:
+	void writeRun();
+
+	FILE* mFile;
+	ReplayRun mRun;
+	uint32_t mTicks;
+};
+
+// ReplayPlayer reads a recording back one tick at a time
+class ReplayPlayer
+{
+public:
+	ReplayPlayer();
+
+	// Reads the whole file. Returns false if it is missing or isn't a complete replay
+	bool open(const char* path);
+
+	// Checks what was asked for on the command line against the recording. -fixed has to match it, and so
+	// does the arena at arenaPath if one was given. Prints why and returns false if they don't
+	bool check(bool fixedPointAsked, const char* arenaPath);
+
+	// Sets a world made from seed up the way the recorded one was: fixed point or not, and its bumpers
+	void setUp(GameWorld& world);
+
+	// Fills in the next tick's inputs. Returns false once every recorded tick has been played
+	bool next(GameInputs& inputs);
+	bool isFinished();
+
+	// Compares the world after the last tick with the recording. Prints the result
+	bool verify(const GameWorld& world);
+
+	// From the file
+	uint64_t seed;
+	bool fixedPoint;
+	std::vector<Bumper> bumpers;
+	uint32_t tickCount;
+	uint64_t checksum;
+
+private:
+	std::vector<ReplayRun> mRuns;
+	size_t mRunIndex;
+	int mRunTicksPlayed;
+	uint32_t mTicksPlayed;
+};
+
+// Plays a recording without a window as fast as possible, then verifies it. Returns true if it matched.
+// The match is set up from the recording. fixedPoint and arenaPath are what the command line asked for,
+// and the replay is refused if they don't match it
+bool playReplayHeadless(const char* path, bool fixedPoint = false, const char* arenaPath = NULL);
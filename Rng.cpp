@@ -0,0 +1,30 @@
+#include "Rng.h"
+
+Rng::Rng(uint64_t seed, uint64_t stream)
+{
+	this->seed(seed, stream);
+}
+
+void Rng::seed(uint64_t seed, uint64_t stream)
+{
+	// Standard PCG seeding: the increment picks the stream and must be odd
+	state = 0;
+	increment = (stream << 1) | 1;
+	next();
+	state += seed;
+	next();
+}
+
+uint32_t Rng::next()
+{
+	uint64_t old = state;
+	state = old * 6364136223846793005ULL + increment;
+	uint32_t xorShifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+	uint32_t rotation = (uint32_t)(old >> 59);
+	return (xorShifted >> rotation) | (xorShifted << ((32 - rotation) & 31));
+}
+
+int Rng::below(int n)
+{
+	return (int)(next() % (uint32_t)n);
+}
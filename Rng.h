@@ -0,0 +1,23 @@
+#pragma once
+#include <stdint.h>
+
+// Rng is a small seedable generator (PCG32) owned by the game state, so a match can be replayed exactly
+// from its seed and inputs. Different streams from the same seed never repeat each other
+class Rng
+{
+public:
+	Rng(uint64_t seed = 1, uint64_t stream = 0);
+
+	// Restarts the sequence
+	void seed(uint64_t seed, uint64_t stream = 0);
+
+	// Next 32 random bits
+	uint32_t next();
+
+	// Random integer from 0 to n - 1. Used where the game used rand() % n
+	int below(int n);
+
+	// Generator state, exposed so it can be saved and checksummed with the rest of the game
+	uint64_t state;
+	uint64_t increment;
+};
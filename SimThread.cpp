@@ -0,0 +1,260 @@
+#include "SimThread.h"
+#include "Trace.h"
+#include <stdio.h>
+
+FrameState::FrameState(const GameWorld& world) : ball(world.ball), player1(world.player1), player2(world.player2)
+{
+	capture(world, 0, SDL_GetPerformanceCounter());
+	inputSequence = 0;
+	inputTime = tickTime;
+}
+
+void FrameState::capture(const GameWorld& world, long long tick, Uint64 time)
+{
+	ball = world.ball;
+	player1 = world.player1;
+	player2 = world.player2;
+
+	// The arrays keep their capacity from frame to frame, so this only copies
+	chaosBalls = world.chaosBalls;
+	player1Score = world.player1Score;
+	player2Score = world.player2Score;
+	state = world.state;
+	winningPlayer = world.winningPlayer;
+	this->tick = tick;
+	tickTime = time;
+}
+
+double FrameState::alpha(Uint64 now, Uint64 tickLength) const
+{
+	if (now <= tickTime)
+	{
+		return 0;
+	}
+	double alpha = (double)(now - tickTime) / tickLength;
+	return alpha < 1 ? alpha : 1;
+}
+
+SimThread::SimThread(GameWorld& world) : mWorld(world), mFrames(FrameState(world))
+{
+	mTick = NULL;
+	mCanPause = NULL;
+	mTickData = NULL;
+	mThread = NULL;
+	mTickLength = SDL_GetPerformanceFrequency() / TICKS_PER_SECOND;
+	mRunning = false;
+	mAxis = 0;
+	mInputSequence = 0;
+	mAdvance = false;
+	mWaiting = false;
+	mWakeEvent = SDL_RegisterEvents(1);
+	mResume = NULL;
+	mPaused = false;
+	mWakeups = 0;
+}
+
+bool SimThread::start(SimTickFunction tick, SimPauseFunction canPause, void* data)
+{
+	mTick = tick;
+	mCanPause = canPause;
+	mTickData = data;
+	mResume = SDL_CreateSemaphore(0);
+	mRunning = true;
+	mThread = mResume != NULL ? SDL_CreateThread(run, "sim", this) : NULL;
+	if (mThread == NULL)
+	{
+		printf("Unable to start the sim thread! SDL Error: %s\n", SDL_GetError());
+		mRunning = false;
+		return false;
+	}
+	return true;
+}
+
+void SimThread::stop()
+{
+	mRunning = false;
+	if (mThread != NULL)
+	{
+		wake();
+		SDL_WaitThread(mThread, NULL);
+		mThread = NULL;
+	}
+	if (mResume != NULL)
+	{
+		SDL_DestroySemaphore(mResume);
+		mResume = NULL;
+	}
+}
+
+Uint32 SimThread::setPlayer1Axis(double axis)
+{
+	// Only this thread writes the sequence. Releasing it makes the axis visible with it
+	Uint32 sequence = mInputSequence.load(std::memory_order_relaxed) + 1;
+	mAxis.store((int)(axis * 32767), std::memory_order_relaxed);
+	mInputSequence.store(sequence, std::memory_order_release);
+	return sequence;
+}
+
+void SimThread::pressAdvance()
+{
+	mAdvance.store(true, std::memory_order_seq_cst);
+	wake();
+}
+
+FrameState& SimThread::latestFrame()
+{
+	return mFrames.read();
+}
+
+bool SimThread::popEvent(GameEvent& event)
+{
+	return mEvents.pop(event);
+}
+
+Uint64 SimThread::getTickLength() const
+{
+	return mTickLength;
+}
+
+void SimThread::setWaiting(bool waiting)
+{
+	mWaiting.store(waiting, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (!waiting)
+	{
+		wake();
+	}
+}
+
+Uint32 SimThread::getWakeEvent() const
+{
+	return mWakeEvent;
+}
+
+int SimThread::takeWakeups()
+{
+	return mWakeups.exchange(0, std::memory_order_relaxed);
+}
+
+bool SimThread::pause()
+{
+	// Announce the sleep before checking, so a main thread clearing waiting or pressing Enter after the
+	// check sees it and posts
+	mPaused.store(true, std::memory_order_seq_cst);
+	bool idle = mWaiting.load(std::memory_order_seq_cst) && !mAdvance.load(std::memory_order_seq_cst)
+		&& mRunning.load(std::memory_order_seq_cst);
+	if (!idle && mPaused.exchange(false))
+	{
+		return false;
+	}
+
+	// Either idle, or someone already took the flag and posted. Both ways one post comes
+	TRACE_ZONE("paused");
+	SDL_SemWait(mResume);
+	mWakeups.fetch_add(1, std::memory_order_relaxed);
+	return idle;
+}
+
+void SimThread::wake()
+{
+	if (mPaused.exchange(false))
+	{
+		SDL_SemPost(mResume);
+	}
+}
+
+int SimThread::run(void* data)
+{
+	((SimThread*)data)->loop();
+	return 0;
+}
+
+void SimThread::loop()
+{
+	TRACE_THREAD("sim");
+	GameInputs inputs;
+	long long tick = 0;
+	Uint32 inputSequence = 0;
+	Uint64 inputTime = 0;
+	Uint64 frequency = SDL_GetPerformanceFrequency();
+	Uint64 nextTick = SDL_GetPerformanceCounter();
+
+	while (mRunning.load(std::memory_order_relaxed))
+	{
+		// Outside play with the main loop waiting, a local match has nothing to tick. Start counting
+		// ticks again from when it wakes
+		bool waiting = mWaiting.load(std::memory_order_relaxed);
+		if (waiting && mWorld.state != STATE_PLAY && mCanPause(mTickData) && pause())
+		{
+			nextTick = SDL_GetPerformanceCounter();
+			continue;
+		}
+
+		// Sleep until the tick is due. SDL_Delay can oversleep by a millisecond, so in play the last one
+		// is spent yielding instead. While the main loop waits a late tick doesn't matter
+		Uint64 now = SDL_GetPerformanceCounter();
+		if (now < nextTick)
+		{
+			Uint32 waitMs = (Uint32)((nextTick - now) * 1000 / frequency);
+			if (waiting)
+			{
+				SDL_Delay(waitMs + 1);
+			}
+			else
+			{
+				SDL_Delay(waitMs > 1 ? waitMs - 1 : 0);
+			}
+			mWakeups.fetch_add(1, std::memory_order_relaxed);
+			continue;
+		}
+
+		// Don't try to catch up after a long stall such as a debugger break
+		if (now - nextTick > MAX_CATCHUP_TICKS * mTickLength)
+		{
+			nextTick = now;
+		}
+		nextTick += mTickLength;
+		TRACE_ZONE("tick");
+
+		// An Enter press is kept until a tick is actually played
+		if (mAdvance.exchange(false, std::memory_order_relaxed))
+		{
+			inputs.advance = true;
+		}
+		// The time kept is when a control was first read, since every tick until the next one reads it again
+		Uint32 sequence = mInputSequence.load(std::memory_order_acquire);
+		inputs.player1Axis = mAxis.load(std::memory_order_relaxed) / 32767.0;
+		if (sequence != inputSequence)
+		{
+			inputSequence = sequence;
+			inputTime = SDL_GetPerformanceCounter();
+		}
+		if (!mTick(mWorld, inputs, mTickData))
+		{
+			continue;
+		}
+		inputs = GameInputs();
+		tick++;
+
+		for (int i = 0; i < mWorld.eventCount; i++)
+		{
+			mEvents.push(mWorld.events[i]);
+		}
+		FrameState& frame = mFrames.back();
+		frame.capture(mWorld, tick, SDL_GetPerformanceCounter());
+		frame.inputSequence = inputSequence;
+		frame.inputTime = inputTime;
+		mFrames.publish();
+
+		// Both sides fence between their store and load, so either a main loop that just set waiting sees
+		// this frame, or this sees waiting and wakes it
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (mWorld.eventCount > 0 && mWakeEvent != (Uint32)-1 && mWaiting.load(std::memory_order_relaxed))
+		{
+			SDL_Event wake;
+			SDL_zero(wake);
+			wake.type = mWakeEvent;
+			SDL_PushEvent(&wake);
+		}
+	}
+}
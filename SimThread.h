@@ -0,0 +1,126 @@
+#pragma once
+#include <SDL.h>
+#include <atomic>
+#include "GameWorld.h"
+#include "SpscQueue.h"
+#include "TripleBuffer.h"
+
+// Most ticks the sim thread plays to catch up after falling behind before it drops the time instead
+const int MAX_CATCHUP_TICKS = 8;
+
+// Events the render thread hasn't turned into sounds yet. A tick emits only a few, so this only fills up
+// if the render thread stalls for a long time, and then the oldest sounds are the ones kept
+const unsigned SIM_EVENT_QUEUE_SIZE = 256;
+
+// Everything the render thread draws, copied out of the world after a tick
+struct FrameState
+{
+	FrameState(const GameWorld& world);
+
+	// Copies the world after a tick. time is the performance counter when the tick finished
+	void capture(const GameWorld& world, long long tick, Uint64 time);
+
+	// How far the frame is between this tick and the next, from 0 to 1
+	double alpha(Uint64 now, Uint64 tickLength) const;
+
+	Ball ball;
+	Paddle player1;
+	Paddle player2;
+	BallPool chaosBalls;
+	int player1Score;
+	int player2Score;
+	GameState state;
+	int winningPlayer;
+
+	// Ticks played so far, and when the last one finished
+	long long tick;
+	Uint64 tickTime;
+
+	// The last player 1 control the tick read, numbered by setPlayer1Axis(), and when a tick first read it
+	Uint32 inputSequence;
+	Uint64 inputTime;
+};
+
+// Plays one tick of the match with the inputs gathered for it. Returns false if it couldn't play the tick
+// yet (netplay waiting on the other side), so the inputs are kept for the next try
+typedef bool (*SimTickFunction)(GameWorld& world, GameInputs& inputs, void* data);
+
+// Whether ticks may stop while the ball is out of play and nobody presses anything. Called on the sim
+// thread, so it may look at whatever the tick function changes
+typedef bool (*SimPauseFunction)(void* data);
+
+// SimThread runs the match on its own thread at exactly TICKS_PER_SECOND, so a slow frame doesn't hold
+// up the ticks. The main thread hands it player 1's controls, and after every tick it publishes a
+// FrameState through a triple buffer and queues the tick's events for sounds. While it runs, the world
+// belongs to the sim thread and the main thread only looks at the published frames. While the main loop
+// waits outside play, ticks would change nothing, so the thread blocks until it is needed again
+class SimThread
+{
+public:
+	SimThread(GameWorld& world);
+
+	// Starts ticking. tick plays each tick, so the game decides where inputs come from, and canPause says
+	// when ticking may stop while idle
+	bool start(SimTickFunction tick, SimPauseFunction canPause, void* data);
+
+	// Stops the thread and waits for it. The world is the caller's again afterwards
+	void stop();
+
+	// Main thread: player 1's paddle control from -1 to 1, and an Enter press for the next tick played.
+	// Returns the control's number, which a frame's inputSequence reaches once a tick has read it
+	Uint32 setPlayer1Axis(double axis);
+	void pressAdvance();
+
+	// Main thread: the latest frame. It stays the same until the next call
+	FrameState& latestFrame();
+
+	// Main thread: the next event the sim thread emitted. False when there are none left
+	bool popEvent(GameEvent& event);
+
+	// Performance counter ticks in one sim tick
+	Uint64 getTickLength() const;
+
+	// Main thread: while waiting is set, every tick that emits events also pushes an SDL event of type
+	// getWakeEvent(), so a main loop blocked in SDL_WaitEventTimeout wakes for state changes and sounds.
+	// Outside play the sim thread sleeps until waiting is cleared or Enter is pressed
+	void setWaiting(bool waiting);
+	Uint32 getWakeEvent() const;
+
+	// Main thread: times the sim thread has woken up since the last call
+	int takeWakeups();
+
+private:
+	static int run(void* data);
+	void loop();
+
+	// Sim thread: blocks until wake() while the main loop waits outside play. Returns true if it slept
+	bool pause();
+
+	// Releases the sim thread from pause(), if it is in it
+	void wake();
+
+	GameWorld& mWorld;
+	SimTickFunction mTick;
+	SimPauseFunction mCanPause;
+	void* mTickData;
+	SDL_Thread* mThread;
+	Uint64 mTickLength;
+	std::atomic<bool> mRunning;
+
+	// Controls from the main thread. The axis is stored in 1/32767ths so it fits in an integer
+	std::atomic<int> mAxis;
+	std::atomic<Uint32> mInputSequence;
+	std::atomic<bool> mAdvance;
+	std::atomic<bool> mWaiting;
+	Uint32 mWakeEvent;
+
+	// Set by the sim thread just before it blocks on mResume, and cleared by whoever posts it, so there is
+	// never more than one post waiting
+	SDL_sem* mResume;
+	std::atomic<bool> mPaused;
+	std::atomic<int> mWakeups;
+
+	// Sim thread to main thread
+	TripleBuffer<FrameState> mFrames;
+	SpscQueue<GameEvent, SIM_EVENT_QUEUE_SIZE> mEvents;
+};
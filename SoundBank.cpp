@@ -0,0 +1,122 @@
+#include "SoundBank.h"
+#include <stdio.h>
+#include <string.h>
+
+// Files for each SoundId, and names for error messages
+static const char* SOUND_FILES[SOUND_COUNT] =
+{
+	"Sounds/player1sound.wav",
+	"Sounds/player2Sound.wav",
+	"Sounds/wallHit.wav",
+	"Sounds/player1score.wav",
+	"Sounds/player2score.wav",
+	"Sounds/player1win.wav",
+	"Sounds/player2win.wav"
+};
+
+static const char* SOUND_NAMES[SOUND_COUNT] =
+{
+	"player 1 sound effect",
+	"player 2 sound effect",
+	"wall hit effect",
+	"player 1 score sound effect",
+	"player 2 score sound effect",
+	"player 1 win sound effect",
+	"player 2 win sound effect"
+};
+
+SoundBank::SoundBank()
+{
+	for (int i = 0; i < SOUND_COUNT; i++)
+	{
+		mChunks[i] = NULL;
+	}
+	mDevice = NULL;
+}
+
+SoundBank::~SoundBank()
+{
+	free();
+}
+
+bool SoundBank::load(AudioDevice& device, AssetPack& assets)
+{
+	// Get rid of sounds converted for a previous device
+	free();
+	mDevice = &device;
+
+	bool success = true;
+	size_t offsets[SOUND_COUNT] = {};
+	size_t lengths[SOUND_COUNT] = {};
+	for (int i = 0; i < SOUND_COUNT; i++)
+	{
+		SDL_AudioSpec spec;
+		Uint8* buffer = NULL;
+		Uint32 length = 0;
+		if (SDL_LoadWAV_RW(assets.openAsset(SOUND_FILES[i]), 1, &spec, &buffer, &length) == NULL)
+		{
+			printf("Failed to load %s! SDL Error: %s\n", SOUND_NAMES[i], SDL_GetError());
+			success = false;
+			continue;
+		}
+
+		// Convert to the device format. The result can be several times longer than the source
+		SDL_AudioCVT cvt;
+		if (SDL_BuildAudioCVT(&cvt, spec.format, spec.channels, spec.freq,
+			device.getFormat(), device.getChannels(), device.getFrequency()) < 0)
+		{
+			printf("Failed to convert %s! SDL Error: %s\n", SOUND_NAMES[i], SDL_GetError());
+			SDL_FreeWAV(buffer);
+			success = false;
+			continue;
+		}
+		std::vector<Uint8> converted(length * cvt.len_mult);
+		memcpy(converted.data(), buffer, length);
+		SDL_FreeWAV(buffer);
+		cvt.buf = converted.data();
+		cvt.len = length;
+		if (cvt.needed && SDL_ConvertAudio(&cvt) < 0)
+		{
+			printf("Failed to convert %s! SDL Error: %s\n", SOUND_NAMES[i], SDL_GetError());
+			success = false;
+			continue;
+		}
+
+		offsets[i] = mSamples.size();
+		lengths[i] = cvt.needed ? cvt.len_cvt : length;
+		mSamples.insert(mSamples.end(), converted.begin(), converted.begin() + lengths[i]);
+	}
+
+	// The block is complete, so it won't move again. Point a chunk at each sound
+	for (int i = 0; i < SOUND_COUNT; i++)
+	{
+		if (lengths[i] > 0)
+		{
+			mChunks[i] = Mix_QuickLoad_RAW(mSamples.data() + offsets[i], (Uint32)lengths[i]);
+		}
+	}
+
+	return success;
+}
+
+void SoundBank::play(SoundId sound)
+{
+	if (mChunks[sound] != NULL && Mix_PlayChannel(-1, mChunks[sound], 0) != -1)
+	{
+		mDevice->soundStarted();
+	}
+}
+
+void SoundBank::free()
+{
+	// Chunks made with Mix_QuickLoad_RAW don't own their samples
+	for (int i = 0; i < SOUND_COUNT; i++)
+	{
+		if (mChunks[i] != NULL)
+		{
+			Mix_FreeChunk(mChunks[i]);
+			mChunks[i] = NULL;
+		}
+	}
+	mSamples.clear();
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <SDL.h>
+#include <SDL_mixer.h>
+#include <vector>
+#include "AssetPack.h"
+#include "AudioDevice.h"
+
+// Every sound effect in the game
+enum SoundId
+{
+	SOUND_PLAYER1_HIT,
+	SOUND_PLAYER2_HIT,
+	SOUND_WALL_HIT,
+	SOUND_PLAYER1_SCORE,
+	SOUND_PLAYER2_SCORE,
+	SOUND_PLAYER1_WIN,
+	SOUND_PLAYER2_WIN,
+	SOUND_COUNT
+};
+
+// SoundBank loads every effect at once, converts them to the device's sample format, rate and channels,
+// and keeps them together in one block of memory. Playing a sound is then only a mix, with no conversion
+// or allocation on the audio thread
+class SoundBank
+{
+public:
+	SoundBank();
+	~SoundBank();
+
+	// Loads and converts every effect for the device. Returns false if any of them couldn't be loaded
+	bool load(AudioDevice& device, AssetPack& assets);
+
+	// Starts a sound on a free channel
+	void play(SoundId sound);
+
+	void free();
+
+private:
+	// Converted samples for every sound, back to back
+	std::vector<Uint8> mSamples;
+
+	// Chunks pointing into mSamples
+	Mix_Chunk* mChunks[SOUND_COUNT];
+
+	AudioDevice* mDevice;
+};
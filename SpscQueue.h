@@ -0,0 +1,49 @@
+#pragma once
+#include <atomic>
+
+// SpscQueue is a fixed size ring for one producer thread and one consumer thread. Each side only
+// writes its own index, so neither takes a lock. Capacity has to be a power of two
+template <typename T, unsigned Capacity>
+class SpscQueue
+{
+public:
+	SpscQueue() : mHead(0), mTail(0)
+	{
+	}
+
+	// Producer side. Returns false, dropping the item, when the queue is full
+	bool push(const T& item)
+	{
+		unsigned tail = mTail.load(std::memory_order_relaxed);
+		if (tail - mHead.load(std::memory_order_acquire) == Capacity)
+		{
+			return false;
+		}
+		mItems[tail & (Capacity - 1)] = item;
+		mTail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer side. Returns false when the queue is empty
+	bool pop(T& item)
+	{
+		unsigned head = mHead.load(std::memory_order_relaxed);
+		if (head == mTail.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+		item = mItems[head & (Capacity - 1)];
+		mHead.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+private:
+	static_assert((Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+	T mItems[Capacity];
+
+	// Indexes only ever count up and wrap. Each one is on its own cache line, so the two threads don't
+	// fight over the line the other one writes
+	alignas(64) std::atomic<unsigned> mHead;
+	alignas(64) std::atomic<unsigned> mTail;
+};
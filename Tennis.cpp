@@ -8,28 +8,36 @@ Paddle::Paddle(double x1, double y1, double w1, double h1)
 	width = w1;
 	height = h1;
 	yVelocity = PADDLE_SPEED;
+	storePrevious();
 }
 
-// Render paddle
-void Paddle::render(SDL_Renderer* renderer)
+// Bounds of the paddle for collision tests
+Box Paddle::box() const
 {
-	SDL_Rect PaddleRect = {this->x, this->y, this->width, this->height};
-	SDL_SetRenderDrawColor(renderer, 0xFF, 0xFF, 0xFF, 0xFF);
-	SDL_RenderFillRect(renderer, &PaddleRect);
+	Box bounds = { x, y, width, height };
+	return bounds;
+}
+
+// Remember where the paddle was before this tick moves it
+void Paddle::storePrevious()
+{
+	prevX = x;
+	prevY = y;
 }
 
 // Ball constructor. Randomize yVelocity 
-Ball::Ball(double x1, double y1, double w1, double h1)
+Ball::Ball(double x1, double y1, double w1, double h1, Rng& rng)
 {
 	x = x1;
 	y = y1;
 	width = w1;
 	height = h1;
-	yVelocity = rand() % 2 == 1 ? .15 * (rand() % 21) : -.15 * (rand() % 21);
+	yVelocity = rng.below(2) == 1 ? .15 * rng.below(21) : -.15 * rng.below(21);
 	xVelocity = -4;
+	storePrevious();
 }
 
-bool Ball::collides(Paddle paddle)
+bool Ball::collides(const Paddle& paddle)
 {
 	// Do the ball and paddle have no overlap in the x plane?
 	if (this->x > paddle.x + paddle.width || paddle.x > this->x + this->width)
@@ -47,19 +55,33 @@ bool Ball::collides(Paddle paddle)
 	return true;
 }
 
+bool Ball::sweep(const Paddle& paddle, double dx, double dy, SweepHit& hit) const
+{
+	return sweepBox(box(), dx, dy, paddle.box(), hit);
+}
+
+// Bounds of the ball for collision tests
+Box Ball::box() const
+{
+	Box bounds = { x, y, width, height };
+	return bounds;
+}
+
 // Resets the ball to center of screen, sets its velocity to -4 to serve to player 1
-void Ball::reset()
+void Ball::reset(Rng& rng)
 {
 	this->x = SCREEN_WIDTH / 2 - this->width / 2;
 	this->y = SCREEN_HEIGHT / 2 - this->height / 2;
-	yVelocity = rand() % 2 == 1 ? .1 * (rand() % 21) : -.1 * (rand() % 21);
+	yVelocity = rng.below(2) == 1 ? .1 * rng.below(21) : -.1 * rng.below(21);
 	xVelocity = -4;
+
+	// The ball jumps to the center, so don't blend it across the court
+	storePrevious();
 }
 
-// Renders the ball
-void Ball::render(SDL_Renderer* renderer)
+// Remember where the ball was before this tick moves it
+void Ball::storePrevious()
 {
-	SDL_Rect ballRect = {this->x, this->y, this->width, this->height};
-	SDL_SetRenderDrawColor(renderer, 0xFF, 0xFF, 0xFF, 0xFF);
-	SDL_RenderFillRect(renderer, &ballRect);
+	prevX = x;
+	prevY = y;
 }
@@ -1,11 +1,15 @@
-#include <SDL.h>
-#include <SDL_image.h>
-#include <SDL_ttf.h>
-#include <SDL_mixer.h>
+#pragma once
 #include <stdio.h>
+#include <stdlib.h>
 #include <string>
 #include <cmath>
 #include <time.h>
+#include "Collision.h"
+#include "Rng.h"
+
+// Every game object's render is defined in TennisRender.cpp, including BallPool's and Arena's, so
+// the game rules build without SDL
+class RenderQueue;
 
 // Global variables for screen dimensions and paddle speed
 const int SCREEN_WIDTH = 864;
@@ -20,9 +24,16 @@ public:
 	//Position, dimensions, velocity of paddle
 	double x = -1, y = -1, width = 10, height = 40, yVelocity;
 
+	// Position at the start of the current simulation tick, blended with x, y when rendering
+	double prevX = -1, prevY = -1;
+
 	// Ctor with member variable parameters
 	Paddle(double x1, double y1, double w1, double h1);
-	void render(SDL_Renderer*); 
+	Box box() const;
+	void storePrevious();
+
+	// Render between the previous and current tick. alpha is how far into the next tick the frame is
+	void render(RenderQueue&, double alpha = 1);
 };
 
 // Ball class contains ball data and functions that reset, handle collision detection, and render the ball
@@ -37,9 +48,18 @@ public:
 	double yVelocity;
 	double xVelocity;
 
-	Ball(double x1, double y1, double w1, double h1);
+	// Position at the start of the current simulation tick, blended with x, y when rendering
+	double prevX = -1, prevY = -1;
+
+	// Random numbers come from the match's generator so a match can be replayed
+	Ball(double x1, double y1, double w1, double h1, Rng& rng);
+
+	bool collides(const Paddle&);
 
-	bool collides(Paddle);
-	void reset();
-	void render(SDL_Renderer*);
+	// Continuous test for the ball moving (dx, dy) this tick, so fast balls can't skip through a paddle
+	bool sweep(const Paddle&, double dx, double dy, SweepHit& hit) const;
+	Box box() const;
+	void reset(Rng& rng);
+	void storePrevious();
+	void render(RenderQueue&, double alpha = 1);
 };
\ No newline at end of file
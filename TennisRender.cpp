@@ -0,0 +1,68 @@
+#include <SDL.h>
+#include "Tennis.h"
+#include "Arena.h"
+#include "BallPool.h"
+#include "RenderQueue.h"
+
+// Paddles and ball are drawn in white, bumpers in light grey
+const SDL_Color OBJECT_COLOR = { 0xFF, 0xFF, 0xFF, 0xFF };
+const SDL_Color BUMPER_COLOR = { 0xB0, 0xB0, 0xB0, 0xFF };
+
+// Height of the strips circles are drawn with
+const int BUMPER_STRIP = 2;
+
+// Render paddle
+void Paddle::render(RenderQueue& queue, double alpha)
+{
+	double renderX = prevX + (x - prevX) * alpha;
+	double renderY = prevY + (y - prevY) * alpha;
+	SDL_Rect PaddleRect = {(int)renderX, (int)renderY, (int)this->width, (int)this->height};
+	queue.addRect(PaddleRect, OBJECT_COLOR);
+}
+
+// Renders the ball
+void Ball::render(RenderQueue& queue, double alpha)
+{
+	double renderX = prevX + (x - prevX) * alpha;
+	double renderY = prevY + (y - prevY) * alpha;
+	SDL_Rect ballRect = {(int)renderX, (int)renderY, (int)this->width, (int)this->height};
+	queue.addRect(ballRect, OBJECT_COLOR);
+}
+
+// Renders every chaos ball in one batch
+void BallPool::render(RenderQueue& queue, double alpha)
+{
+	float blend = (float)alpha;
+	for (int i = 0; i < mCount; i++)
+	{
+		mRenderX[i] = prevX[i] + (x[i] - prevX[i]) * blend;
+		mRenderY[i] = prevY[i] + (y[i] - prevY[i]) * blend;
+	}
+	queue.addRects(mRenderX.data(), mRenderY.data(), mCount, CHAOS_BALL_SIZE, CHAOS_BALL_SIZE, OBJECT_COLOR);
+}
+
+// Renders every bumper. Circles are stacked strips, which is plenty for shapes this small
+void Arena::render(RenderQueue& queue) const
+{
+	for (size_t i = 0; i < bumpers.size(); i++)
+	{
+		const Box& box = bumpers[i].box;
+		if (bumpers[i].shape == BUMPER_RECT)
+		{
+			SDL_Rect rect = { (int)box.x, (int)box.y, (int)box.w, (int)box.h };
+			queue.addRect(rect, BUMPER_COLOR, LAYER_BACKGROUND);
+			continue;
+		}
+
+		double radius = box.w / 2;
+		double centerX = box.x + radius;
+		double centerY = box.y + radius;
+		for (double y = box.y; y < box.y + box.h; y += BUMPER_STRIP)
+		{
+			double middle = y + BUMPER_STRIP / 2.0 - centerY;
+			double halfWidth = sqrt(fmax(0, radius * radius - middle * middle));
+			SDL_Rect strip = { (int)(centerX - halfWidth), (int)y, (int)(halfWidth * 2), BUMPER_STRIP };
+			queue.addRect(strip, BUMPER_COLOR, LAYER_BACKGROUND);
+		}
+	}
+}
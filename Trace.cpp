@@ -0,0 +1,155 @@
+#include "Trace.h"
+#include <stdio.h>
+
+#ifdef TRACE_ENABLED
+#include <atomic>
+#include <vector>
+
+// Every field is atomic so a dump can read a zone while its thread writes another. Relaxed loads and
+// stores of them are plain moves
+struct TraceEvent
+{
+	std::atomic<const char*> name;
+	std::atomic<int64_t> start;
+	std::atomic<int64_t> end;
+};
+
+// One thread's ring of zones. claimed counts zones the thread has started writing and committed the ones
+// it has finished, so a dump can tell which entries it read might have been overwritten meanwhile
+struct TraceBuffer
+{
+	TraceEvent events[TRACE_BUFFER_ZONES];
+	std::atomic<uint64_t> claimed;
+	std::atomic<uint64_t> committed;
+	std::atomic<const char*> threadName;
+	int id;
+	TraceBuffer* next;
+};
+
+// Every thread's buffer, newest first. Buffers are never freed, so the zones of threads that have finished,
+// like the loader's, are still in the trace
+static std::atomic<TraceBuffer*> traceBuffers(nullptr);
+static std::atomic<int> traceBufferCount(0);
+static thread_local TraceBuffer* threadBuffer = nullptr;
+
+// The calling thread's buffer, made and added to the list the first time the thread traces anything
+static TraceBuffer* getThreadBuffer()
+{
+	if (threadBuffer == nullptr)
+	{
+		TraceBuffer* buffer = new TraceBuffer();
+		buffer->claimed = 0;
+		buffer->committed = 0;
+		buffer->threadName = nullptr;
+		buffer->id = ++traceBufferCount;
+		buffer->next = traceBuffers.load();
+		while (!traceBuffers.compare_exchange_weak(buffer->next, buffer))
+		{
+		}
+		threadBuffer = buffer;
+	}
+	return threadBuffer;
+}
+
+void traceRecord(const char* name, int64_t start, int64_t end)
+{
+	TraceBuffer* buffer = getThreadBuffer();
+	uint64_t index = buffer->committed.load(std::memory_order_relaxed);
+
+	// Claim the slot before overwriting it, so a dump reading the old zone there knows to drop it
+	buffer->claimed.store(index + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	TraceEvent& event = buffer->events[index & (TRACE_BUFFER_ZONES - 1)];
+	event.name.store(name, std::memory_order_relaxed);
+	event.start.store(start, std::memory_order_relaxed);
+	event.end.store(end, std::memory_order_relaxed);
+	buffer->committed.store(index + 1, std::memory_order_release);
+}
+
+void traceThreadName(const char* name)
+{
+	getThreadBuffer()->threadName.store(name, std::memory_order_relaxed);
+}
+
+// A zone copied out of a buffer
+struct TraceCopy
+{
+	const char* name;
+	int64_t start;
+	int64_t end;
+	int thread;
+};
+
+bool traceWrite(const char* path)
+{
+	// Copy each ring, then drop anything its thread may have started overwriting while it was copied
+	std::vector<TraceCopy> zones;
+	int64_t origin = INT64_MAX;
+	for (TraceBuffer* buffer = traceBuffers.load(std::memory_order_acquire); buffer != nullptr; buffer = buffer->next)
+	{
+		uint64_t last = buffer->committed.load(std::memory_order_acquire);
+		uint64_t first = last > TRACE_BUFFER_ZONES ? last - TRACE_BUFFER_ZONES : 0;
+		size_t copied = zones.size();
+		for (uint64_t i = first; i < last; i++)
+		{
+			const TraceEvent& event = buffer->events[i & (TRACE_BUFFER_ZONES - 1)];
+			TraceCopy zone = { event.name.load(std::memory_order_relaxed), event.start.load(std::memory_order_relaxed),
+				event.end.load(std::memory_order_relaxed), buffer->id };
+			zones.push_back(zone);
+		}
+		std::atomic_thread_fence(std::memory_order_acquire);
+		uint64_t claimed = buffer->claimed.load(std::memory_order_relaxed);
+		uint64_t firstIntact = claimed > TRACE_BUFFER_ZONES ? claimed - TRACE_BUFFER_ZONES : 0;
+		uint64_t dropUntil = firstIntact < last ? firstIntact : last;
+		if (dropUntil > first)
+		{
+			zones.erase(zones.begin() + copied, zones.begin() + copied + (size_t)(dropUntil - first));
+		}
+		for (size_t i = copied; i < zones.size(); i++)
+		{
+			origin = zones[i].start < origin ? zones[i].start : origin;
+		}
+	}
+
+	FILE* file = fopen(path, "w");
+	if (file == NULL)
+	{
+		printf("Unable to write trace to %s!\n", path);
+		return false;
+	}
+
+	// Complete events, in microseconds from the earliest zone, then a name for every thread
+	fprintf(file, "{\"traceEvents\":[\n");
+	bool first = true;
+	for (const TraceCopy& zone : zones)
+	{
+		fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", first ? "" : ",\n",
+			zone.name, zone.thread, (zone.start - origin) / 1000.0, (zone.end - zone.start) / 1000.0);
+		first = false;
+	}
+	for (TraceBuffer* buffer = traceBuffers.load(std::memory_order_acquire); buffer != nullptr; buffer = buffer->next)
+	{
+		const char* name = buffer->threadName.load(std::memory_order_relaxed);
+		if (name != nullptr)
+		{
+			fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", first ? "" : ",\n",
+				buffer->id, name);
+			first = false;
+		}
+	}
+	fprintf(file, "\n]}\n");
+	fclose(file);
+	printf("Wrote %d trace zones to %s\n", (int)zones.size(), path);
+	return true;
+}
+
+#else
+
+bool traceWrite(const char* path)
+{
+	printf("Tracing is compiled out. Build with -DTRACE=ON or as Debug to write %s\n", path);
+	return false;
+}
+
+#endif
@@ -0,0 +1,59 @@
+#pragma once
+#include <stdint.h>
+#include <chrono>
+
+// Zones each thread keeps. Older ones are overwritten, so at the main thread's dozen zones a frame a dump
+// covers the last minute and a half of play
+const int TRACE_BUFFER_ZONES = 1 << 16;
+
+// Scoped trace zones. TRACE_ZONE("name") times from where it is declared to the end of the enclosing
+// scope, and TRACE_THREAD("name") names the calling thread in the trace. Each thread writes its zones to
+// its own ring buffer without locks, and a zone costs two clock reads and a few stores. Zones are only
+// compiled in with TRACE_ENABLED, which the build defines for Debug builds or with -DTRACE=ON. Otherwise
+// the macros are empty. Names have to be string literals or otherwise live for the whole run
+#ifdef TRACE_ENABLED
+
+// Nanoseconds on the trace clock
+inline int64_t traceNow()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Adds a finished zone to the calling thread's buffer, for spans not shaped like a scope
+void traceRecord(const char* name, int64_t start, int64_t end);
+
+void traceThreadName(const char* name);
+
+class TraceZone
+{
+public:
+	TraceZone(const char* name) : mName(name), mStart(traceNow())
+	{
+	}
+
+	~TraceZone()
+	{
+		traceRecord(mName, mStart, traceNow());
+	}
+
+private:
+	const char* mName;
+	int64_t mStart;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_ZONE(name) TraceZone TRACE_CONCAT(traceZone, __LINE__)(name)
+#define TRACE_THREAD(name) traceThreadName(name)
+
+#else
+
+#define TRACE_ZONE(name) do {} while (0)
+#define TRACE_THREAD(name) do {} while (0)
+
+#endif
+
+// Writes every thread's zones as Chrome trace JSON, which chrome://tracing and ui.perfetto.dev open.
+// Other threads can keep tracing while it runs. Returns false, saying why, if tracing is compiled out or
+// the file can't be written
+bool traceWrite(const char* path);
@@ -0,0 +1,48 @@
+#pragma once
+#include <atomic>
+
+// TripleBuffer hands whole values from one writer thread to one reader thread without locks or waiting.
+// Of the three slots the writer owns one, the reader owns one, and the third sits between them holding
+// the latest published value. Publishing swaps the writer's slot into the middle, and reading swaps the
+// middle out if something new was published since the last read. Neither side ever blocks the other,
+// and the reader always gets the newest complete value. Values the reader was too slow to see are skipped
+template <typename T>
+class TripleBuffer
+{
+public:
+	// Every slot starts as a copy of initial, so the reader has something before the first publish
+	TripleBuffer(const T& initial) : mSlots{ initial, initial, initial }, mMiddle(1), mBack(2), mFront(0)
+	{
+	}
+
+	// Writer side: the slot to fill in, then publish it. The slot changes after every publish
+	T& back()
+	{
+		return mSlots[mBack];
+	}
+
+	void publish()
+	{
+		mBack = mMiddle.exchange(mBack | FRESH, std::memory_order_acq_rel) & INDEX;
+	}
+
+	// Reader side: the latest published value. It stays the reader's, unchanged, until the next read
+	T& read()
+	{
+		if (mMiddle.load(std::memory_order_relaxed) & FRESH)
+		{
+			mFront = mMiddle.exchange(mFront, std::memory_order_acq_rel) & INDEX;
+		}
+		return mSlots[mFront];
+	}
+
+private:
+	// The middle index carries a flag for a value the reader hasn't taken yet
+	static const int INDEX = 3;
+	static const int FRESH = 4;
+
+	T mSlots[3];
+	std::atomic<int> mMiddle;
+	int mBack;
+	int mFront;
+};
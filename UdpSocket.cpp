@@ -0,0 +1,164 @@
+#include "UdpSocket.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+UdpSocket::UdpSocket()
+{
+	mSocket = 0;
+	mOpen = false;
+	memset(&mPeer, 0, sizeof(mPeer));
+	mHasPeer = false;
+}
+
+UdpSocket::~UdpSocket()
+{
+	close();
+}
+
+bool UdpSocket::open(int port)
+{
+	close();
+
+#ifdef _WIN32
+	// Winsock has to be started before any socket call. Repeated starts are counted, and close stops one
+	WSADATA wsaData;
+	if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+	{
+		printf("Unable to start Winsock!\n");
+		return false;
+	}
+#endif
+
+	mSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+#ifdef _WIN32
+	bool created = mSocket != INVALID_SOCKET;
+#else
+	bool created = mSocket >= 0;
+#endif
+	if (!created)
+	{
+		printf("Unable to create UDP socket!\n");
+#ifdef _WIN32
+		WSACleanup();
+#endif
+		return false;
+	}
+	mOpen = true;
+
+	sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_ANY);
+	address.sin_port = htons((uint16_t)port);
+	if (bind(mSocket, (sockaddr*)&address, sizeof(address)) != 0)
+	{
+		printf("Unable to bind UDP port %d!\n", port);
+		close();
+		return false;
+	}
+
+	// Never wait on the network inside a frame
+#ifdef _WIN32
+	u_long nonBlocking = 1;
+	ioctlsocket(mSocket, FIONBIO, &nonBlocking);
+#else
+	fcntl(mSocket, F_SETFL, fcntl(mSocket, F_GETFL, 0) | O_NONBLOCK);
+#endif
+	return true;
+}
+
+bool UdpSocket::connect(const char* host, int port)
+{
+	addrinfo hints;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_DGRAM;
+	addrinfo* result = NULL;
+	if (getaddrinfo(host, NULL, &hints, &result) != 0 || result == NULL)
+	{
+		printf("Unable to find host %s!\n", host);
+		return false;
+	}
+
+	memcpy(&mPeer, result->ai_addr, sizeof(mPeer));
+	mPeer.sin_port = htons((uint16_t)port);
+	mHasPeer = true;
+	freeaddrinfo(result);
+	return true;
+}
+
+void UdpSocket::send(const uint8_t* data, int size)
+{
+	if (mOpen && mHasPeer)
+	{
+		sendto(mSocket, (const char*)data, size, 0, (sockaddr*)&mPeer, sizeof(mPeer));
+	}
+}
+
+int UdpSocket::receive(uint8_t* data, int size)
+{
+	if (!mOpen)
+	{
+		return 0;
+	}
+
+	// Only the peer is listened to once there is one. Anything else is skipped
+	for (;;)
+	{
+		sockaddr_in from;
+		socklen_t fromSize = sizeof(from);
+		int received = (int)recvfrom(mSocket, (char*)data, size, 0, (sockaddr*)&from, &fromSize);
+		if (received <= 0)
+		{
+			return 0;
+		}
+
+		if (!mHasPeer)
+		{
+			mPeer = from;
+			mHasPeer = true;
+		}
+		if (from.sin_addr.s_addr == mPeer.sin_addr.s_addr && from.sin_port == mPeer.sin_port)
+		{
+			return received;
+		}
+	}
+}
+
+int UdpSocket::getPort() const
+{
+	sockaddr_in address;
+	socklen_t size = sizeof(address);
+	if (!mOpen || getsockname(mSocket, (sockaddr*)&address, &size) != 0)
+	{
+		return 0;
+	}
+	return ntohs(address.sin_port);
+}
+
+void UdpSocket::close()
+{
+	if (!mOpen)
+	{
+		return;
+	}
+
+#ifdef _WIN32
+	closesocket(mSocket);
+	WSACleanup();
+#else
+	::close(mSocket);
+#endif
+	mOpen = false;
+	mHasPeer = false;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+typedef SOCKET SocketHandle;
+#else
+#include <netinet/in.h>
+typedef int SocketHandle;
+#endif
+
+// UdpSocket is a non-blocking UDP socket talking to one peer, for netplay. The host binds a known port
+// and takes the first address that sends to it as its peer; the joining side connects to the host
+class UdpSocket
+{
+public:
+	UdpSocket();
+	~UdpSocket();
+
+	// Binds a port, or any free one for 0
+	bool open(int port);
+
+	// Sends to this address from now on. Host is a name or dotted address
+	bool connect(const char* host, int port);
+
+	// Sends a datagram to the peer. Quietly does nothing without one
+	void send(const uint8_t* data, int size);
+
+	// Next waiting datagram, or 0 when there is none. Without a peer yet, the sender becomes the peer
+	int receive(uint8_t* data, int size);
+
+	int getPort() const;
+	void close();
+
+private:
+	SocketHandle mSocket;
+	bool mOpen;
+	sockaddr_in mPeer;
+	bool mHasPeer;
+};
@@ -0,0 +1,108 @@
+// Asset packer. Bundles the font and sounds into one indexed file the game reads in a single open:
+//   assetpack OUTPUT FILE...
+// Assets are stored under the names given, relative to the working directory
+#include "PackFormat.h"
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+using namespace std;
+
+static void writeValue(FILE* file, uint32_t value)
+{
+	for (int i = 0; i < 4; i++)
+	{
+		fputc((int)((value >> (8 * i)) & 0xFF), file);
+	}
+}
+
+static bool readFile(const char* path, vector<unsigned char>& data)
+{
+	FILE* file = fopen(path, "rb");
+	if (file == NULL)
+	{
+		return false;
+	}
+
+	unsigned char buffer[4096];
+	size_t read;
+	while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+	{
+		data.insert(data.end(), buffer, buffer + read);
+	}
+	fclose(file);
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 3)
+	{
+		printf("Usage: assetpack OUTPUT FILE...\n");
+		return 1;
+	}
+
+	int count = argc - 2;
+	vector<PackEntry> entries(count);
+	vector<vector<unsigned char> > contents(count);
+
+	// Data follows the index, each asset aligned
+	uint32_t offset = PACK_HEADER_SIZE + count * PACK_ENTRY_SIZE;
+	for (int i = 0; i < count; i++)
+	{
+		const char* name = argv[i + 2];
+		if (strlen(name) >= (size_t)PACK_NAME_LENGTH)
+		{
+			printf("Asset name %s is too long!\n", name);
+			return 1;
+		}
+		if (!readFile(name, contents[i]))
+		{
+			printf("Unable to read %s!\n", name);
+			return 1;
+		}
+
+		offset = (offset + PACK_ALIGNMENT - 1) / PACK_ALIGNMENT * PACK_ALIGNMENT;
+		memset(entries[i].name, 0, PACK_NAME_LENGTH);
+		strcpy(entries[i].name, name);
+		entries[i].offset = offset;
+		entries[i].size = (uint32_t)contents[i].size();
+		offset += entries[i].size;
+	}
+
+	FILE* file = fopen(argv[1], "wb");
+	if (file == NULL)
+	{
+		printf("Unable to create %s!\n", argv[1]);
+		return 1;
+	}
+
+	writeValue(file, PACK_MAGIC);
+	writeValue(file, PACK_VERSION);
+	writeValue(file, (uint32_t)count);
+	for (int i = 0; i < count; i++)
+	{
+		fwrite(entries[i].name, 1, PACK_NAME_LENGTH, file);
+		writeValue(file, entries[i].offset);
+		writeValue(file, entries[i].size);
+	}
+	for (int i = 0; i < count; i++)
+	{
+		// Pad up to the asset's offset
+		while ((uint32_t)ftell(file) < entries[i].offset)
+		{
+			fputc(0, file);
+		}
+		fwrite(contents[i].data(), 1, contents[i].size(), file);
+	}
+
+	bool written = ferror(file) == 0;
+	if (fclose(file) != 0 || !written)
+	{
+		printf("Unable to finish writing %s!\n", argv[1]);
+		return 1;
+	}
+
+	printf("Packed %d assets into %s (%u bytes)\n", count, argv[1], offset);
+	return 0;
+}
@@ -0,0 +1,548 @@
+// Microbenchmarks of the game's hot paths, written out as JSON so two builds can be compared with
+// bench_compare.py. Each benchmark is run several times and the median is kept.
+//   bench [-out FILE] [-filter TEXT]
+//   bench -alloccheck
+// -filter only runs benchmarks whose name contains TEXT. Built with SDL, the text and frame benchmarks
+// draw with SDL's software renderer into a surface, so no window or GPU is needed. -alloccheck runs no
+// benchmarks. It plays a match the way the game does and exits with an error if steady play allocates
+#include "AllocTracker.h"
+#include "GameWorld.h"
+#include "Trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+#ifdef BENCH_SDL
+#include <SDL.h>
+#include <SDL_ttf.h>
+#include "AssetPack.h"
+#include "CourtLayer.h"
+#include "GlyphAtlas.h"
+#include "ParticlePool.h"
+#include "RenderQueue.h"
+#include "RenderStats.h"
+#include "SimThread.h"
+#include "Texture.h"
+#endif
+
+using namespace std;
+
+// Runs of every benchmark. The median is reported, which shrugs off the odd slow run
+const int BENCH_RUNS = 9;
+
+// Each run is repeated until it takes at least this long, so the timer's resolution doesn't matter
+const double BENCH_MIN_RUN_SECONDS = 0.02;
+
+// Results kept from reaching the optimizer
+volatile double benchSink;
+
+struct BenchResult
+{
+	string name;
+	double nsPerOp;
+	long long iterations;
+};
+
+vector<BenchResult> results;
+const char* benchFilter = NULL;
+
+// Times body(iterations), which has to run the operation that many times and return something that
+// depends on the work
+template <typename Body>
+void runBench(const char* name, Body body)
+{
+	if (benchFilter != NULL && strstr(name, benchFilter) == NULL)
+	{
+		return;
+	}
+
+	// Double the iterations until one run is long enough
+	long long iterations = 1;
+	for (;;)
+	{
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		benchSink = body(iterations);
+		double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		if (seconds >= BENCH_MIN_RUN_SECONDS)
+		{
+			break;
+		}
+		iterations *= 2;
+	}
+
+	double runs[BENCH_RUNS];
+	for (int run = 0; run < BENCH_RUNS; run++)
+	{
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		benchSink = body(iterations);
+		runs[run] = chrono::duration<double>(chrono::steady_clock::now() - start).count() * 1e9 / iterations;
+	}
+	sort(runs, runs + BENCH_RUNS);
+
+	BenchResult result = { name, runs[BENCH_RUNS / 2], iterations };
+	results.push_back(result);
+	printf("%-24s %12.1f ns/op\n", name, result.nsPerOp);
+}
+
+// Bot that holds the stick toward the ball once it is coming, and starts every rally
+GameInputs botInputs(const GameWorld& world)
+{
+	GameInputs inputs;
+	inputs.advance = world.state != STATE_PLAY;
+	if (world.ball.xVelocity < 0)
+	{
+		double offset = world.ball.y + world.ball.height / 2 - (world.player1.y + world.player1.height / 2);
+		inputs.player1Axis = fmax(-1, fmin(1, offset / PLAYER1_SPEED));
+	}
+	return inputs;
+}
+
+void benchCore()
+{
+	// Overlap test against a paddle, for a spread of ball positions that hit and miss
+	runBench("ball_collides", [](long long iterations)
+	{
+		Rng rng(1);
+		Paddle paddle(10, 200, 10, 40);
+		vector<Ball> balls;
+		for (int i = 0; i < 64; i++)
+		{
+			balls.push_back(Ball(rng.below(40), 180 + rng.below(80), 10, 10, rng));
+		}
+		long long hits = 0;
+		for (long long i = 0; i < iterations; i++)
+		{
+			hits += balls[i & 63].collides(paddle);
+		}
+		return (double)hits;
+	});
+
+	// One whole tick of a match, bot against the AI
+	runBench("game_tick", [](long long iterations)
+	{
+		GameWorld world(1);
+		for (long long i = 0; i < iterations; i++)
+		{
+			world.step(botInputs(world));
+		}
+		return (double)world.checksum();
+	});
+
+	// The same match with fixed point physics
+	runBench("game_tick_fixed", [](long long iterations)
+	{
+		GameWorld world(1);
+		world.fixedPoint = true;
+		for (long long i = 0; i < iterations; i++)
+		{
+			world.step(botInputs(world));
+		}
+		return (double)world.checksum();
+	});
+
+	// A ball's path swept against a paddle, in doubles and then in fixed point, for a spread of paths that
+	// hit and miss
+	runBench("sweep_box", [](long long iterations)
+	{
+		Rng rng(1);
+		Box paddle = { 10, 200, 10, 40 };
+		Box balls[64];
+		double dx[64];
+		double dy[64];
+		for (int i = 0; i < 64; i++)
+		{
+			Box ball = { 20.0 + rng.below(40), 180.0 + rng.below(80), 10, 10 };
+			balls[i] = ball;
+			dx[i] = -(rng.below(240) / 10.0);
+			dy[i] = rng.below(41) / 10.0 - 2;
+		}
+		long long hits = 0;
+		SweepHit hit;
+		for (long long i = 0; i < iterations; i++)
+		{
+			hits += sweepBox(balls[i & 63], dx[i & 63], dy[i & 63], paddle, hit);
+		}
+		return (double)hits;
+	});
+
+	runBench("sweep_box_fixed", [](long long iterations)
+	{
+		Rng rng(1);
+		Box paddleBox = { 10, 200, 10, 40 };
+		FixedBox paddle = toFixed(paddleBox);
+		FixedBox balls[64];
+		Fixed dx[64];
+		Fixed dy[64];
+		for (int i = 0; i < 64; i++)
+		{
+			Box ball = { 20.0 + rng.below(40), 180.0 + rng.below(80), 10, 10 };
+			balls[i] = toFixed(ball);
+			dx[i] = Fixed::fromDouble(-(rng.below(240) / 10.0));
+			dy[i] = Fixed::fromDouble(rng.below(41) / 10.0 - 2);
+		}
+		long long hits = 0;
+		FixedHit hit;
+		for (long long i = 0; i < iterations; i++)
+		{
+			hits += sweepBoxFixed(balls[i & 63], dx[i & 63], dy[i & 63], paddle, hit);
+		}
+		return (double)hits;
+	});
+
+#ifdef TRACE_ENABLED
+	// What a trace zone costs, so tracing can be left on
+	runBench("trace_zone", [](long long iterations)
+	{
+		for (long long i = 0; i < iterations; i++)
+		{
+			TRACE_ZONE("bench");
+		}
+		return (double)iterations;
+	});
+#endif
+
+	// The AI following its plan, which is what it does on almost every tick
+	runBench("ai_update", [](long long iterations)
+	{
+		GameWorld world(1);
+		AiPlanner ai;
+		Paddle paddle = world.player2;
+		for (long long i = 0; i < iterations; i++)
+		{
+			ai.update(world.ball, 1, paddle, DEFAULT_AI_SKILL, world.rng);
+		}
+		return paddle.y;
+	});
+
+	// The AI working out a new plan, which happens when the ball changes course
+	runBench("ai_replan", [](long long iterations)
+	{
+		GameWorld world(1);
+		world.ball.xVelocity = 4;
+		AiPlanner ai;
+		Paddle paddle = world.player2;
+		for (long long i = 0; i < iterations; i++)
+		{
+			ai.replan(true);
+			ai.update(world.ball, 1, paddle, DEFAULT_AI_SKILL, world.rng);
+		}
+		return paddle.y;
+	});
+}
+
+#ifdef BENCH_SDL
+const SDL_Color BENCH_WHITE = { 0xFF, 0xFF, 0xFF, 0xFF };
+
+// SDL's software renderer drawing into a surface the size of the window, with the score font's glyphs,
+// a court layer and the game's particles
+struct RenderTarget
+{
+	SDL_Surface* surface = NULL;
+	SDL_Renderer* renderer = NULL;
+	AssetPack assetPack;
+	TTF_Font* font = NULL;
+	GlyphAtlas atlas;
+	int face = -1;
+	CourtLayer courtLayer;
+	RenderQueue queue;
+	ParticlePool particles;
+
+	bool open()
+	{
+		if (SDL_Init(0) < 0 || TTF_Init() == -1)
+		{
+			printf("Unable to start SDL! SDL Error: %s\n", SDL_GetError());
+			return false;
+		}
+		surface = SDL_CreateRGBSurfaceWithFormat(0, SCREEN_WIDTH, SCREEN_HEIGHT, 32, SDL_PIXELFORMAT_RGBA32);
+		renderer = surface != NULL ? SDL_CreateSoftwareRenderer(surface) : NULL;
+		assetPack.open(ASSET_PACK_FILE);
+		font = TTF_OpenFontRW(assetPack.openAsset("slkscr.ttf"), 1, 70);
+		if (renderer == NULL || font == NULL)
+		{
+			printf("Unable to set up the software renderer! SDL Error: %s\n", SDL_GetError());
+			return false;
+		}
+		face = atlas.addFont(font);
+		return atlas.build(renderer, BENCH_WHITE) && courtLayer.create(renderer, SCREEN_WIDTH, SCREEN_HEIGHT);
+	}
+
+	void close()
+	{
+		courtLayer.free();
+		atlas.free();
+		TTF_CloseFont(font);
+		assetPack.free();
+		SDL_DestroyRenderer(renderer);
+		SDL_FreeSurface(surface);
+		TTF_Quit();
+		SDL_Quit();
+	}
+};
+
+bool benchRender()
+{
+	RenderTarget target;
+	if (!target.open())
+	{
+		return false;
+	}
+	SDL_Renderer* renderer = target.renderer;
+	TTF_Font* font = target.font;
+	GlyphAtlas& atlas = target.atlas;
+	int face = target.face;
+	CourtLayer& courtLayer = target.courtLayer;
+	RenderQueue& queue = target.queue;
+	const SDL_Color& white = BENCH_WHITE;
+	// A score drawn the way the game first did it: a new texture from the font every time
+	runBench("text_rendered_texture", [&](long long iterations)
+	{
+		Texture texture;
+		for (long long i = 0; i < iterations; i++)
+		{
+			texture.loadFromRenderedText(renderer, to_string(i % 10), white, font);
+			texture.render(renderer, SCREEN_WIDTH / 2 - 100, 100);
+		}
+		return (double)texture.getWidth();
+	});
+
+	// The same score from the glyph atlas, which only queues a copy
+	runBench("text_glyph_atlas", [&](long long iterations)
+	{
+		char text[16];
+		int drawCalls = 0;
+		for (long long i = 0; i < iterations; i++)
+		{
+			snprintf(text, sizeof(text), "%d", (int)(i % 10));
+			atlas.render(queue, face, text, SCREEN_WIDTH / 2 - 100, 100);
+			drawCalls += queue.flush(renderer);
+		}
+		return (double)drawCalls;
+	});
+
+	// A whole frame of a match in play: the court layer, paddles and ball, submitted and presented
+	runBench("full_frame", [&](long long iterations)
+	{
+		GameWorld world(1);
+		courtLayer.beginRebuild(renderer);
+		for (int y = 0; y < SCREEN_HEIGHT; y += 20)
+		{
+			SDL_Rect dash = { SCREEN_WIDTH / 2 - 2, y, 4, 10 };
+			queue.addRect(dash, white, LAYER_BACKGROUND);
+		}
+		atlas.render(queue, face, "3", SCREEN_WIDTH / 2 - 100, 100);
+		atlas.render(queue, face, "5", SCREEN_WIDTH / 2 + 60, 100);
+		queue.flush(renderer);
+		courtLayer.endRebuild(renderer);
+
+		for (long long i = 0; i < iterations; i++)
+		{
+			world.step(botInputs(world));
+			SDL_SetRenderDrawColor(renderer, 0x00, 0x00, 0x00, 0x00);
+			SDL_RenderClear(renderer);
+			courtLayer.render(queue);
+			world.ball.render(queue, 0.5);
+			world.player1.render(queue, 0.5);
+			world.player2.render(queue, 0.5);
+			queue.flush(renderer);
+			SDL_RenderPresent(renderer);
+		}
+		return (double)world.checksum();
+	});
+
+	// A frame of effects with the pool kept full: moving every particle, spawning the frame's budget of
+	// score bursts and drawing them all as one batch
+	runBench("particles_frame", [&](long long iterations)
+	{
+		ParticlePool& particles = target.particles;
+		GameEvent burst = { EVENT_PLAYER1_SCORE, SCREEN_WIDTH / 2.0, SCREEN_HEIGHT / 2.0, MAX_BALL_SPEED };
+		int drawCalls = 0;
+		for (long long i = 0; i < iterations; i++)
+		{
+			particles.update(1.0f / TICKS_PER_SECOND);
+			for (int j = 0; j < 4; j++)
+			{
+				particles.addEffect(burst);
+			}
+			particles.render(queue);
+			drawCalls += queue.flush(renderer);
+		}
+		particles.clear();
+		return (double)drawCalls;
+	});
+
+	target.close();
+	return true;
+}
+
+// Draws a frame the way the game does, redrawing the court layer only when the score or state changed
+void drawFrame(RenderTarget& target, FrameState& frame, const Arena& arena, int& shownScores)
+{
+	int scores = frame.player1Score * 100 + frame.player2Score + frame.state * 10000;
+	if (scores != shownScores)
+	{
+		char scoreText[16];
+		target.courtLayer.beginRebuild(target.renderer);
+		arena.render(target.queue);
+		snprintf(scoreText, sizeof(scoreText), "%d", frame.player1Score);
+		target.atlas.render(target.queue, target.face, scoreText, SCREEN_WIDTH / 2 - 100, 100);
+		snprintf(scoreText, sizeof(scoreText), "%d", frame.player2Score);
+		target.atlas.render(target.queue, target.face, scoreText, SCREEN_WIDTH / 2 + 60, 100);
+		target.queue.flush(target.renderer);
+		target.courtLayer.endRebuild(target.renderer);
+		shownScores = scores;
+	}
+
+	SDL_SetRenderDrawColor(target.renderer, 0x00, 0x00, 0x00, 0x00);
+	SDL_RenderClear(target.renderer);
+	target.courtLayer.render(target.queue);
+	frame.chaosBalls.render(target.queue, 0.5);
+	frame.ball.render(target.queue, 0.5);
+	frame.player1.render(target.queue, 0.5);
+	frame.player2.render(target.queue, 0.5);
+	target.particles.render(target.queue);
+	target.queue.flush(target.renderer);
+	SDL_RenderPresent(target.renderer);
+}
+#endif
+
+// Ticks played before the allocation check starts counting: long enough for points to be scored and for
+// every buffer to reach its working size
+const int ALLOC_WARMUP_TICKS = TICKS_PER_SECOND * 30;
+
+// Ticks counted, which take the match through several restarts
+const int ALLOC_CHECK_TICKS = TICKS_PER_SECOND * 60 * 5;
+
+// Chaos balls and a few bumpers, so every part of a tick runs
+const int ALLOC_CHECK_CHAOS_BALLS = 1000;
+
+// Plays a match bot against AI, handing every tick over as a frame through a triple buffer and drawing it
+// when built with SDL, like the game does. After the warm up nothing may touch the heap or create a surface
+// or texture. Returns false if anything did
+bool checkAllocations()
+{
+	GameWorld world(1);
+	world.chaosBalls.spawn(ALLOC_CHECK_CHAOS_BALLS);
+	for (int i = 0; i < 4; i++)
+	{
+		Bumper bumper = { i % 2 == 0 ? BUMPER_RECT : BUMPER_CIRCLE, { 200.0 + i * 140, 120.0 + i * 60, 24, 24 } };
+		world.arena.add(bumper);
+	}
+	world.arena.bake();
+
+#ifdef BENCH_SDL
+	RenderTarget target;
+	if (!target.open())
+	{
+		return false;
+	}
+	target.queue.reserve(ALLOC_CHECK_CHAOS_BALLS + PARTICLE_CAPACITY);
+	TripleBuffer<FrameState> frames((FrameState(world)));
+	int shownScores = -1;
+	int texturesBefore = 0;
+	int surfacesBefore = 0;
+#endif
+
+	long long allocationsBefore = 0;
+	for (int tick = 0; tick < ALLOC_WARMUP_TICKS + ALLOC_CHECK_TICKS; tick++)
+	{
+		if (tick == ALLOC_WARMUP_TICKS)
+		{
+			allocationsBefore = allocationCount();
+#ifdef BENCH_SDL
+			texturesBefore = renderStats.texturesCreated;
+			surfacesBefore = renderStats.surfacesCreated;
+#endif
+		}
+
+		world.step(botInputs(world));
+#ifdef BENCH_SDL
+		target.particles.update(1.0f / TICKS_PER_SECOND);
+		for (int i = 0; i < world.eventCount; i++)
+		{
+			target.particles.addEffect(world.events[i]);
+		}
+		// The trail as dense as it gets, as if the ball were always at top speed
+		if (world.state == STATE_PLAY)
+		{
+			const Ball& ball = world.ball;
+			target.particles.addTrail((float)ball.prevX, (float)ball.prevY, (float)ball.x, (float)ball.y, (float)MAX_BALL_SPEED);
+		}
+		frames.back().capture(world, tick, 0);
+		frames.publish();
+		drawFrame(target, frames.read(), world.arena, shownScores);
+#endif
+	}
+
+	long long allocations = allocationCount() - allocationsBefore;
+	printf("Heap allocations in %d ticks of steady play: %lld\n", ALLOC_CHECK_TICKS, allocations);
+	bool clean = allocations == 0;
+#ifdef BENCH_SDL
+	int textures = renderStats.texturesCreated - texturesBefore;
+	int surfaces = renderStats.surfacesCreated - surfacesBefore;
+	printf("Textures created: %d, surfaces created: %d\n", textures, surfaces);
+	clean = clean && textures == 0 && surfaces == 0;
+	target.close();
+#endif
+	printf(clean ? "Steady play is allocation free\n" : "Steady play allocates!\n");
+	return clean;
+}
+
+int main(int argc, char* argv[])
+{
+	const char* outPath = "bench.json";
+	bool allocCheck = false;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-out") == 0 && i + 1 < argc)
+		{
+			outPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "-filter") == 0 && i + 1 < argc)
+		{
+			benchFilter = argv[++i];
+		}
+		else if (strcmp(argv[i], "-alloccheck") == 0)
+		{
+			allocCheck = true;
+		}
+		else
+		{
+			printf("Unknown option %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	if (allocCheck)
+	{
+		return checkAllocations() ? 0 : 1;
+	}
+
+	benchCore();
+#ifdef BENCH_SDL
+	if (!benchRender())
+	{
+		return 1;
+	}
+#endif
+
+	FILE* file = fopen(outPath, "w");
+	if (file == NULL)
+	{
+		printf("Unable to write %s!\n", outPath);
+		return 1;
+	}
+	fprintf(file, "{\n  \"benchmarks\": [\n");
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		fprintf(file, "    { \"name\": \"%s\", \"ns_per_op\": %.3f, \"iterations\": %lld }%s\n", results[i].name.c_str(),
+			results[i].nsPerOp, results[i].iterations, i + 1 < results.size() ? "," : "");
+	}
+	fprintf(file, "  ]\n}\n");
+	fclose(file);
+	printf("Wrote %s\n", outPath);
+	return 0;
+}
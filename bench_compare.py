@@ -0,0 +1,43 @@
+#!/usr/bin/env python3
+# Compares two bench JSON files and flags every benchmark that got slower by more than the threshold.
+#   bench_compare.py BASELINE.json NEW.json [--threshold PERCENT]
+# Exits with 1 if anything regressed, so it can gate a change to the game loop.
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        return {b["name"]: b["ns_per_op"] for b in json.load(f)["benchmarks"]}
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Flag benchmark regressions between two bench runs.")
+    parser.add_argument("baseline")
+    parser.add_argument("new")
+    parser.add_argument("--threshold", type=float, default=5.0, help="percent slowdown allowed (default 5)")
+    args = parser.parse_args()
+
+    baseline = load(args.baseline)
+    new = load(args.new)
+
+    regressed = False
+    print("%-24s %12s %12s %9s" % ("benchmark", "baseline ns", "new ns", "change"))
+    for name in sorted(set(baseline) | set(new)):
+        if name not in baseline or name not in new:
+            print("%-24s %s" % (name, "only in " + (args.new if name in new else args.baseline)))
+            continue
+
+        change = (new[name] - baseline[name]) / baseline[name] * 100
+        flag = ""
+        if change > args.threshold:
+            flag = "  REGRESSION"
+            regressed = True
+        print("%-24s %12.1f %12.1f %+8.1f%%%s" % (name, baseline[name], new[name], change, flag))
+
+    return 1 if regressed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -4,65 +4,88 @@
 #include <SDL_ttf.h>
 #include <SDL_mixer.h>
 #include <stdio.h>
+#include <string.h>
 #include <string>
 #include <cmath>
 #include <Tennis.h>
+#include "GameWorld.h"
+#include "AllocTracker.h"
+#include "AssetLoader.h"
+#include "AssetPack.h"
+#include "AudioDevice.h"
+#include "CourtLayer.h"
+#include "FrameCapture.h"
+#include "GlyphAtlas.h"
+#include "InputSampler.h"
+#include "LatencyProbe.h"
+#include "NetSession.h"
+#include "ParticlePool.h"
+#include "PerfHud.h"
+#include "RenderQueue.h"
+#include "RenderStats.h"
+#include "Replay.h"
+#include "SimThread.h"
+#include "SoundBank.h"
+#include "Texture.h"
+#include "Trace.h"
+#include "UdpSocket.h"
 
 using namespace std;
 
-// This class wraps the SDL texture so we can easily load media and render
-// Can't be in a separate file because it needs to use the same renderer pointer that main uses
-class Texture
-{
-public:
-	// Initializes variables
-	Texture();
-
-	// Deallocates memory
-	~Texture();
+// Starts up SDL and creates window
+bool init();
 
-	// Loads image at specified path
-	bool loadFromFile(string path);
+// Loads media. Fonts and sounds are loaded by the loader's threads
+bool loadMedia(AssetLoader& loader);
 
-	// Creates image from font string
-	bool loadFromRenderedText(string textureText, SDL_Color textColor, TTF_Font* font);
+// Loader jobs, run on worker threads while the window shows the court
+int loadFonts(void* data);
+int loadSounds(void* data);
 
-	// Deallocates texture
-	void free();
+// Frees media and shuts down SDL
+void close();
 
-	// Set color modulation
-	void setColor(Uint8 red, Uint8 green, Uint8 blue);
+// Plays the sound for something that happened during a tick
+void playSound(GameEventType type);
 
-	// Set blending
-	void setBlendMode(SDL_BlendMode blending);
+// Where a tick's inputs come from and where they go. Used only by the sim thread while it runs
+struct MatchControl
+{
+	bool netplay;
+	bool hosting;
+	NetHello hello;
+	UdpSocket* netSocket;
+	NetSession* netSession;
+	ReplayPlayer* replay;
+	bool replaying;
+	ReplayRecorder* recorder;
+};
 
-	// Set alpha modulation
-	void setAlpha(Uint8 alpha);
+// Plays a tick on the sim thread: over the network, from a replay, or from player 1's controls
+bool playTick(GameWorld& world, GameInputs& inputs, void* data);
 
-	// Renders texture at given point
-	void render(int x, int y, SDL_Rect* clip = NULL, double angle = 0.0, SDL_Point* center = NULL, SDL_RendererFlip flip = SDL_FLIP_NONE);
+// Whether the sim thread may stop ticking while idle. Netplay has to keep trading packets, and a replay
+// presses Enter by itself
+bool canPauseTicks(void* data);
 
-	// Gets image dimensions
-	int getWidth();
-	int getHeight();
+// Port a netplay host listens on unless one is given
+const int DEFAULT_NET_PORT = 27015;
 
-private:
-	// The actual hardware texture
-	SDL_Texture* mTexture;
+// How long the joining side keeps saying hello before giving up, in tries 100ms apart
+const int NET_HELLO_TRIES = 100;
 
-	// Image dimensions
-	int mWidth;
-	int mHeight;
-};
+// Longest the main loop sleeps while nothing on screen moves, before checking on the audio device again
+const int IDLE_WAIT_MS = 500;
 
-// Starts up SDL and creates window
-bool init();
+// Netplay handshake, before the window opens. The host waits for a hello and answers with the match seed,
+// which the joining side takes into hello. Either side refuses when the other plays with other settings
+bool connectNetplay(UdpSocket& socket, bool hosting, NetHello& hello);
 
-// Loads media
-bool loadMedia();
+// Takes in everything the other side has sent. The host answers a repeated hello again, in case its answer was lost
+void receiveNetplay(UdpSocket& socket, NetSession& session, bool hosting, const NetHello& hello);
 
-// Frees media and shuts down SDL
-void close();
+// Queues everything that stays still between score changes: title, court markings, scores and message
+void drawCourt(RenderQueue& queue, const FrameState& frame, const Arena& arena);
 
 // The window we'll be rendering to
 SDL_Window* window = NULL;
@@ -76,170 +99,29 @@ TTF_Font* scoreFont = NULL;
 TTF_Font* messageFont = NULL;
 
 // Globally used color (white)
-SDL_Color textColor = { 0xFF, 0xFF, 0xFF };
-
-// Rendered textures for title, UI message, and both paddles
-Texture titleTexture, p1Texture, p2Texture, msgTexture;
-
-// Pointers for sounds
-Mix_Chunk* player1sound = NULL;
-Mix_Chunk* player2sound = NULL;
-Mix_Chunk* player1score = NULL;
-Mix_Chunk* player2score = NULL;
-Mix_Chunk* player1win = NULL;
-Mix_Chunk* player2win = NULL;
-Mix_Chunk* wallhitSound = NULL;
-
-// Texture constructor
-Texture::Texture()
-{
-	// Initialize
-	mTexture = NULL;
-	mWidth = 0;
-	mHeight = 0;
-}
+SDL_Color textColor = { 0xFF, 0xFF, 0xFF, 0xFF };
 
-// Destructor
-Texture::~Texture()
-{
-	// Deallocate
-	free();
-}
+// Every glyph of the three fonts, rasterized once. Faces index the fonts inside the atlas
+GlyphAtlas textAtlas;
+int titleFace = -1;
+int scoreFace = -1;
+int messageFace = -1;
 
-// This function loads files into textures
-bool Texture::loadFromFile(string path)
-{
-	// Get rid of preexisting texture
-	free();
+// Title, court markings, scores and messages, cached in a texture and redrawn only when they change
+CourtLayer courtLayer;
 
-	// The final texture
-	SDL_Texture* newTexture = NULL;
+// Font and sounds, read from disk in one go
+AssetPack assetPack;
 
-	// Load image at specified path
-	SDL_Surface* loadedSurface = IMG_Load(path.c_str());
-	if (loadedSurface == NULL)
-	{
-		printf("Unable to load image %s! SDL_image Error: %s\n", path.c_str(), IMG_GetError());
-	}
-	else
-	{
-		// Color key image
-		SDL_SetColorKey(loadedSurface, SDL_TRUE, SDL_MapRGB(loadedSurface->format, 0, 0xFF, 0xFF));
+// Audio output and every sound effect, converted for it. The buffer size can be set with -audiobuffer
+AudioDevice audioDevice;
+SoundBank soundBank;
+int audioBufferFrames = AUDIO_LOW_LATENCY_FRAMES;
 
-		// Create texture from surface pixels
-		newTexture = SDL_CreateTextureFromSurface(renderer, loadedSurface);
-		if (newTexture == NULL)
-		{
-			printf("Unable to create texture from %s! SDL Error: %s\n", path.c_str(), SDL_GetError());
-		}
-		else
-		{
-			// Get image dimensions
-			mWidth = loadedSurface->w;
-			mHeight = loadedSurface->h;
-		}
-
-		// Get rid of old loaded surface
-		SDL_FreeSurface(loadedSurface);
-	}
-
-	// Return success
-	mTexture = newTexture;
-	return mTexture != NULL;
-}
-
-// This function loads text into a texture of the chosen font
-bool Texture::loadFromRenderedText(string textureText, SDL_Color textColor, TTF_Font* font)
-{
-	// Get rid of preexisting texture
-	free();
-
-	// Render text surface
-	SDL_Surface* textSurface = TTF_RenderText_Solid(font, textureText.c_str(), textColor);
-	if (textSurface == NULL)
-	{
-		printf("Unable to render text surface! SDL_ttf Error: %s\n", TTF_GetError());
-	}
-	else
-	{
-		// Create texture from surface pixels
-		mTexture = SDL_CreateTextureFromSurface(renderer, textSurface);
-		if (mTexture == NULL)
-		{
-			printf("Unable to create texture from rendered text! SDL Error: %s\n", SDL_GetError());
-		}
-		else
-		{
-			// Get image dimensions
-			mWidth = textSurface->w;
-			mHeight = textSurface->h;
-		}
-
-		// Get rid of old surface
-		SDL_FreeSurface(textSurface);
-	}
-
-	// Return success
-	return mTexture != NULL;
-}
-
-// Frees memory when done
-void Texture::free()
-{
-	// Free texture if it exists
-	if (mTexture != NULL)
-	{
-		SDL_DestroyTexture(mTexture);
-		mTexture = NULL;
-		mWidth = 0;
-		mHeight = 0;
-	}
-}
-
-
-void Texture::setColor(Uint8 red, Uint8 green, Uint8 blue)
-{
-	// Modulate texture rgb
-	SDL_SetTextureColorMod(mTexture, red, green, blue);
-}
-
-void Texture::setBlendMode(SDL_BlendMode blending)
-{
-	// Set blending function
-	SDL_SetTextureBlendMode(mTexture, blending);
-}
-
-void Texture::setAlpha(Uint8 alpha)
-{
-	// Modulate texture alpha
-	SDL_SetTextureAlphaMod(mTexture, alpha);
-}
-
-void Texture::render(int x, int y, SDL_Rect* clip, double angle, SDL_Point* center, SDL_RendererFlip flip)
-{
-	// Set rendering space and render to screen
-	SDL_Rect renderQuad = { x, y, mWidth, mHeight };
-
-	// Set clip rendering dimensions
-	if (clip != NULL)
-	{
-		renderQuad.w = clip->w;
-		renderQuad.h = clip->h;
-	}
-
-	// Render to screen
-	SDL_RenderCopyEx(renderer, mTexture, clip, &renderQuad, angle, center, flip);
-}
-
-int Texture::getWidth()
-{
-	return mWidth;
-}
-
-int Texture::getHeight()
-{
-	return mHeight;
-}
+// Loader jobs, and whether the sounds can be played yet
+int fontJob = -1;
+int soundJob = -1;
+bool soundsReady = false;
 
 // Initializes the framework, the window, and the renderer
 bool init()
@@ -248,7 +130,7 @@ bool init()
 	bool success = true;
 
 	// Initialize SDL
-	if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) < 0)
+	if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_GAMECONTROLLER) < 0)
 	{
 		printf("SDL could not initialize! SDL Error: %s\n", SDL_GetError());
 		success = false;
@@ -271,7 +153,7 @@ bool init()
 		else
 		{
 			// Create vsynced renderer for window
-			renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+			renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC | SDL_RENDERER_TARGETTEXTURE);
 			if (renderer == NULL)
 			{
 				printf("Renderer could not be created! SDL Error: %s\n", SDL_GetError());
@@ -296,13 +178,6 @@ bool init()
 					printf("SDL_ttf could not initialize! SDL_ttf Error: %s\n", TTF_GetError());
 					success = false;
 				}
-
-				// Initialize SDL_Mixer
-				if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048) < 0)
-				{
-					printf("SDL_mixer could not initialize! SDL_mixer Error: %s\n", Mix_GetError());
-					success = false;
-				}
 			}
 		}
 	}
@@ -311,113 +186,80 @@ bool init()
 }
 
 // Loads the silkscreen retro font and sets it to the start screen
-bool loadMedia()
+bool loadMedia(AssetLoader& loader)
 {
 	// Loading success flag
 	bool success = true;
 
-	// Open the fonts
-	titleFont = TTF_OpenFont("slkscr.ttf", 28);
-	scoreFont = TTF_OpenFont("slkscr.ttf", 70);
-	messageFont = TTF_OpenFont("slkscr.ttf", 21);
-
-	if (!titleFont || !scoreFont || !messageFont)
-	{
-		printf("Failed to load silkscreen font! SDL_ttf Error: %s\n", TTF_GetError());
-		success = false;
-	}
-	else
-	{
-		// Load title and initial score into texture
-		if (!titleTexture.loadFromRenderedText("Bumper Tennis", textColor, titleFont) 			
-			|| !msgTexture.loadFromRenderedText("by Austin Listerud. Press Enter to begin.", textColor, messageFont))
-		{
-			printf("Failed to render text texture!\n");
-			success = false;
-		}
-	}
-
-	//Load sound effects
-	player1sound = Mix_LoadWAV("Sounds/player1sound.wav");
-	if (player1sound == NULL)
-	{
-		printf("Failed to load player 1 sound effect! SDL_mixer Error: %s\n", Mix_GetError());
-		success = false;
-	}
+	// Everything is read from one pack next to the executable, or from loose files if there isn't one
+	assetPack.open(ASSET_PACK_FILE);
 
-	player2sound = Mix_LoadWAV("Sounds/player2sound.wav");
-	if (player2sound == NULL)
+	// Without a court layer the court is drawn every frame instead
+	if (!courtLayer.create(renderer, SCREEN_WIDTH, SCREEN_HEIGHT))
 	{
-		printf("Failed to load player 2 sound effect! SDL_mixer Error: %s\n", Mix_GetError());
-		success = false;
+		printf("Warning: Court layer not available, drawing the court every frame!\n");
 	}
 
-	player1score = Mix_LoadWAV("Sounds/player1score.wav");
-	if (player1score == NULL)
+	// Fonts and sounds load in the background. The window shows the court and paddles meanwhile
+	fontJob = loader.start("fonts", loadFonts, NULL);
+	soundJob = loader.start("sounds", loadSounds, NULL);
+	if (fontJob == -1 || soundJob == -1)
 	{
-		printf("Failed to load player 1 score sound effect! SDL_mixer Error: %s\n", Mix_GetError());
 		success = false;
 	}
 
-	player2score = Mix_LoadWAV("Sounds/player2score.wav");
-	if (player2score == NULL)
-	{
-		printf("Failed to load player 2 score sound effect! SDL_mixer Error: %s\n", Mix_GetError());
-		success = false;
-	}
+	return success;
+}
 
-	player1win = Mix_LoadWAV("Sounds/player1win.wav");
-	if (player1win == NULL)
-	{
-		printf("Failed to load player 1 win sound effect! SDL_mixer Error: %s\n", Mix_GetError());
-		success = false;
-	}
+// Opens the fonts and rasterizes their glyphs. The main thread uploads them when this finishes
+int loadFonts(void*)
+{
+	// Open the fonts. All three sizes parse the same font bytes in the pack
+	titleFont = TTF_OpenFontRW(assetPack.openAsset("slkscr.ttf"), 1, 28);
+	scoreFont = TTF_OpenFontRW(assetPack.openAsset("slkscr.ttf"), 1, 70);
+	messageFont = TTF_OpenFontRW(assetPack.openAsset("slkscr.ttf"), 1, 21);
 
-	player2win = Mix_LoadWAV("Sounds/player2win.wav");
-	if (player2win == NULL)
+	if (!titleFont || !scoreFont || !messageFont)
 	{
-		printf("Failed to load player 2 win sound effect! SDL_mixer Error: %s\n", Mix_GetError());
-		success = false;
+		printf("Failed to load silkscreen font! SDL_ttf Error: %s\n", TTF_GetError());
+		return 0;
 	}
 
-	wallhitSound = Mix_LoadWAV("Sounds/wallHit.wav");
-	if (wallhitSound == NULL)
+	// Rasterize every glyph of all three sizes for one texture, so no text is rendered during play
+	titleFace = textAtlas.addFont(titleFont);
+	scoreFace = textAtlas.addFont(scoreFont);
+	messageFace = textAtlas.addFont(messageFont);
+	if (!textAtlas.rasterize(textColor))
 	{
-		printf("Failed to load wall hit effect! SDL_mixer Error: %s\n", Mix_GetError());
-		success = false;
+		printf("Failed to build glyph atlas!\n");
+		return 0;
 	}
+	return 1;
+}
 
-	return success;
+// Opens the audio device, which can take a while, then loads the sound effects converted for it
+int loadSounds(void*)
+{
+	return audioDevice.open(audioBufferFrames) && soundBank.load(audioDevice, assetPack);
 }
 
 // Frees memory when the program closes
 void close()
 {
 	// Free textures
-	titleTexture.free();
-	p1Texture.free();
-	p2Texture.free();
+	textAtlas.free();
+	courtLayer.free();
 
 	// Free fonts
 	TTF_CloseFont(titleFont);
 	TTF_CloseFont(scoreFont);
-	titleFont = scoreFont = NULL;
-
-	// Free sounds and set pointers to null
-	Mix_FreeChunk(player1sound);
-	player1sound = NULL;
-	Mix_FreeChunk(player2sound);
-	player2sound = NULL;
-	Mix_FreeChunk(player1score);
-	player1score = NULL;
-	Mix_FreeChunk(player2score);
-	player2score = NULL;
-	Mix_FreeChunk(player1win);
-	player1win = NULL;
-	Mix_FreeChunk(player2win);
-	player2win = NULL;
-	Mix_FreeChunk(wallhitSound);
-	wallhitSound = NULL;
+	TTF_CloseFont(messageFont);
+	titleFont = scoreFont = messageFont = NULL;
+	assetPack.free();
+
+	// Free sounds and close the audio device
+	soundBank.free();
+	audioDevice.close();
 
 	// Destroy window	
 	SDL_DestroyRenderer(renderer);
@@ -433,8 +275,345 @@ void close()
 }
 
 
+bool connectNetplay(UdpSocket& socket, bool hosting, NetHello& hello)
+{
+	uint8_t packet[NET_MAX_PACKET];
+	NetHello received;
+	if (hosting)
+	{
+		printf("Waiting for a player on port %d\n", socket.getPort());
+		for (;;)
+		{
+			// The answer goes back either way, so the other side can tell why it was refused
+			int size = socket.receive(packet, sizeof(packet));
+			if (size > 0 && NetSession::readHello(packet, size, received))
+			{
+				socket.send(packet, NetSession::writeHello(packet, hello));
+				if (!NetSession::helloAgrees(hello, received))
+				{
+					printf("Refused the connection!\n");
+					return false;
+				}
+				return true;
+			}
+			SDL_Delay(10);
+		}
+	}
+
+	for (int i = 0; i < NET_HELLO_TRIES; i++)
+	{
+		socket.send(packet, NetSession::writeHello(packet, hello));
+		SDL_Delay(100);
+		int size;
+		while ((size = socket.receive(packet, sizeof(packet))) > 0)
+		{
+			if (NetSession::readHello(packet, size, received))
+			{
+				if (!NetSession::helloAgrees(hello, received))
+				{
+					printf("The host refused the connection!\n");
+					return false;
+				}
+				hello.seed = received.seed;
+				return true;
+			}
+		}
+	}
+	printf("Unable to reach the host!\n");
+	return false;
+}
+
+void receiveNetplay(UdpSocket& socket, NetSession& session, bool hosting, const NetHello& hello)
+{
+	uint8_t packet[NET_MAX_PACKET];
+	NetHello received;
+	int size;
+	while ((size = socket.receive(packet, sizeof(packet))) > 0)
+	{
+		if (NetSession::readHello(packet, size, received))
+		{
+			if (hosting)
+			{
+				socket.send(packet, NetSession::writeHello(packet, hello));
+			}
+		}
+		else
+		{
+			session.readInputs(packet, size);
+		}
+	}
+}
+
+bool playTick(GameWorld& world, GameInputs& inputs, void* data)
+{
+	MatchControl& match = *(MatchControl*)data;
+
+	// Over the network the session plays the tick, rewinding first if the other side's inputs changed
+	// the past. Every try sends a packet, whether or not the tick could be played
+	if (match.netplay)
+	{
+		receiveNetplay(*match.netSocket, *match.netSession, match.hosting, match.hello);
+		bool played = match.netSession->advance(world, inputs.player1Axis, inputs.advance);
+		uint8_t packet[NET_MAX_PACKET];
+		match.netSocket->send(packet, match.netSession->writeInputs(packet));
+		return played;
+	}
+
+	// Recorded inputs replace the player's. When they run out, check the match ended up where the recording did and hand over control
+	if (match.replaying && !match.replay->next(inputs))
+	{
+		match.replay->verify(world);
+		match.replaying = false;
+	}
+	match.recorder->record(inputs);
+	world.step(inputs);
+	return true;
+}
+
+bool canPauseTicks(void* data)
+{
+	MatchControl& match = *(MatchControl*)data;
+	return !match.netplay && !match.replaying;
+}
+
+// Plays the sound for something that happened during a tick
+void playSound(GameEventType type)
+{
+	switch (type)
+	{
+	case EVENT_PLAYER1_HIT:
+		soundBank.play(SOUND_PLAYER1_HIT);
+		break;
+	case EVENT_PLAYER2_HIT:
+		soundBank.play(SOUND_PLAYER2_HIT);
+		break;
+	case EVENT_WALL_HIT:
+	case EVENT_BUMPER_HIT:
+		soundBank.play(SOUND_WALL_HIT);
+		break;
+	case EVENT_PLAYER1_SCORE:
+		soundBank.play(SOUND_PLAYER1_SCORE);
+		break;
+	case EVENT_PLAYER2_SCORE:
+		soundBank.play(SOUND_PLAYER2_SCORE);
+		break;
+	case EVENT_PLAYER1_WIN:
+		soundBank.play(SOUND_PLAYER1_WIN);
+		break;
+	case EVENT_PLAYER2_WIN:
+		soundBank.play(SOUND_PLAYER2_WIN);
+		break;
+	default:
+		break;
+	}
+}
+
+// Court markings: a dashed net down the middle, starting below the title and message
+const int NET_TOP = 120;
+const int NET_DASH = 12;
+const int NET_WIDTH = 4;
+const SDL_Color NET_COLOR = { 0x40, 0x40, 0x40, 0xFF };
+
+void drawCourt(RenderQueue& queue, const FrameState& frame, const Arena& arena)
+{
+	// Buffers for text that changes
+	char scoreText[16];
+	char msgText[64];
+
+	// Net
+	for (int y = NET_TOP; y < SCREEN_HEIGHT; y += 2 * NET_DASH)
+	{
+		SDL_Rect dash = { SCREEN_WIDTH / 2 - NET_WIDTH / 2, y, NET_WIDTH, NET_DASH };
+		queue.addRect(dash, NET_COLOR, LAYER_BACKGROUND);
+	}
+
+	// Bumpers
+	arena.render(queue);
+
+	// Text shows up once the fonts have loaded
+	if (!textAtlas.isReady())
+	{
+		return;
+	}
+
+	// Set UI message, e.g. "Press enter" or "Player 1 wins!" No message during play.
+	if (frame.state == STATE_START)
+	{
+		snprintf(msgText, sizeof(msgText), "by Austin Listerud. Press Enter to begin.");
+	}
+	else if (frame.state == STATE_SERVE)
+	{
+		snprintf(msgText, sizeof(msgText), "Player 1's serve. Press Enter.");
+	}
+	else if (frame.state == STATE_DONE)
+	{
+		snprintf(msgText, sizeof(msgText), "Player %d wins! Press Enter to restart", frame.winningPlayer);
+	}
+	if (frame.state != STATE_PLAY)
+	{
+		textAtlas.render(queue, messageFace, msgText, SCREEN_WIDTH / 2 - textAtlas.getTextWidth(messageFace, msgText) / 2, 80);
+	}
+
+	// Render title of game
+	textAtlas.render(queue, titleFace, "Bumper Tennis", (SCREEN_WIDTH - textAtlas.getTextWidth(titleFace, "Bumper Tennis")) / 2, (SCREEN_HEIGHT - textAtlas.getHeight(titleFace)) / 20);
+
+	// Display score straight from the atlas
+	snprintf(scoreText, sizeof(scoreText), "%d", frame.player1Score);
+	textAtlas.render(queue, scoreFace, scoreText, SCREEN_WIDTH / 2 - 100, (SCREEN_HEIGHT - textAtlas.getHeight(scoreFace)) / 3);
+	snprintf(scoreText, sizeof(scoreText), "%d", frame.player2Score);
+	textAtlas.render(queue, scoreFace, scoreText, SCREEN_WIDTH / 2 + 100 - textAtlas.getTextWidth(scoreFace, scoreText), (SCREEN_HEIGHT - textAtlas.getHeight(scoreFace)) / 3);
+}
+
 int main(int argc, char* args[])
 {
+	// Startup is timed from here until everything has loaded
+	AssetLoader loader(SDL_GetPerformanceCounter());
+	TRACE_THREAD("main");
+
+	// Command line: -seed N picks the match, -record FILE saves every tick's inputs, -replay FILE plays a
+	// recording back in the window, and -replay FILE -headless plays it without one as fast as possible.
+	// -audiobuffer FRAMES sets the starting audio buffer size, -chaos BALLS adds that many chaos balls,
+	// and -arena FILE loads a bumper layout. -host [PORT] waits for a second player over the network,
+	// who plays player 2 with -join HOST[:PORT]. -fixed plays with fixed point physics, which both sides
+	// of a network match and a replay need to agree on. -capture FILE records the window to a raw video file,
+	// and -wakeups prints how often the main loop woke up and drew every second
+	uint64_t seed = (uint64_t)time(NULL);
+	const char* recordPath = NULL;
+	const char* replayPath = NULL;
+	bool headless = false;
+	int chaosBalls = 0;
+	const char* arenaPath = NULL;
+	bool hosting = false;
+	const char* joinHost = NULL;
+	int netPort = DEFAULT_NET_PORT;
+	bool fixedPoint = false;
+	const char* capturePath = NULL;
+	bool reportWakeups = false;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(args[i], "-seed") == 0 && i + 1 < argc)
+		{
+			seed = strtoull(args[++i], NULL, 10);
+		}
+		else if (strcmp(args[i], "-record") == 0 && i + 1 < argc)
+		{
+			recordPath = args[++i];
+		}
+		else if (strcmp(args[i], "-replay") == 0 && i + 1 < argc)
+		{
+			replayPath = args[++i];
+		}
+		else if (strcmp(args[i], "-audiobuffer") == 0 && i + 1 < argc)
+		{
+			audioBufferFrames = atoi(args[++i]);
+		}
+		else if (strcmp(args[i], "-chaos") == 0 && i + 1 < argc)
+		{
+			chaosBalls = atoi(args[++i]);
+		}
+		else if (strcmp(args[i], "-arena") == 0 && i + 1 < argc)
+		{
+			arenaPath = args[++i];
+		}
+		else if (strcmp(args[i], "-host") == 0)
+		{
+			hosting = true;
+			if (i + 1 < argc && args[i + 1][0] != '-')
+			{
+				netPort = atoi(args[++i]);
+			}
+		}
+		else if (strcmp(args[i], "-join") == 0 && i + 1 < argc)
+		{
+			// HOST or HOST:PORT
+			joinHost = args[++i];
+			const char* colon = strrchr(joinHost, ':');
+			if (colon != NULL)
+			{
+				static char hostName[256];
+				snprintf(hostName, sizeof(hostName), "%.*s", (int)(colon - joinHost), joinHost);
+				netPort = atoi(colon + 1);
+				joinHost = hostName;
+			}
+		}
+		else if (strcmp(args[i], "-headless") == 0)
+		{
+			headless = true;
+		}
+		else if (strcmp(args[i], "-fixed") == 0)
+		{
+			fixedPoint = true;
+		}
+		else if (strcmp(args[i], "-capture") == 0 && i + 1 < argc)
+		{
+			capturePath = args[++i];
+		}
+		else if (strcmp(args[i], "-wakeups") == 0)
+		{
+			reportWakeups = true;
+		}
+		else
+		{
+			printf("Unknown option %s\n", args[i]);
+		}
+	}
+
+	// A headless replay only needs the game rules
+	if (headless)
+	{
+		if (replayPath == NULL)
+		{
+			printf("-headless needs a replay to play\n");
+			return 1;
+		}
+		return playReplayHeadless(replayPath, fixedPoint, arenaPath) ? 0 : 1;
+	}
+
+	// Netplay needs both sides to play the same match from the same seed, so it can't be mixed with
+	// replays, and chaos balls aren't rewound with the rest of the match
+	bool netplay = hosting || joinHost != NULL;
+	UdpSocket netSocket;
+	NetHello hello = { seed, fixedPoint, 0 };
+	if (netplay)
+	{
+		if (recordPath != NULL || replayPath != NULL || chaosBalls > 0)
+		{
+			printf("Netplay ignores -record, -replay and -chaos\n");
+			recordPath = NULL;
+			replayPath = NULL;
+			chaosBalls = 0;
+		}
+
+		// The arena is loaded here only to tell the other side which one this is
+		Arena arena;
+		if (arenaPath != NULL)
+		{
+			arena.load(arenaPath);
+		}
+		hello.arenaHash = arena.hash();
+		if (!netSocket.open(hosting ? netPort : 0) || (!hosting && !netSocket.connect(joinHost, netPort))
+			|| !connectNetplay(netSocket, hosting, hello))
+		{
+			return 1;
+		}
+		seed = hello.seed;
+	}
+	NetSession netSession(joinHost != NULL ? 2 : 1);
+
+	// A replay plays the match it was recorded from, with the recorded settings. One that doesn't match
+	// the -fixed or -arena asked for isn't played at all
+	ReplayPlayer replay;
+	bool replaying = false;
+	if (replayPath != NULL)
+	{
+		if (!replay.open(replayPath) || !replay.check(fixedPoint, arenaPath))
+		{
+			return 1;
+		}
+		replaying = true;
+		seed = replay.seed;
+	}
+
 	// Start up SDL and create window
 	if (!init())
 	{
@@ -442,31 +621,46 @@ int main(int argc, char* args[])
 	}
 	else
 	{
-		// Load media
-		if (!loadMedia())
+		loader.windowShown();
+
+		// Start loading media
+		if (!loadMedia(loader))
 		{
 			printf("Failed to load media!\n");
 		}
 		else
 		{
-			// Initialize player scores, serving player (always 1 after adding AI), and winning player 
-			int player1Score = 0;
-			int player2Score = 0;
-			int servingPlayer = 1;
-			int winningPlayer; 
-
-			// Seed RNG, initialize paddles, the AI's velocity, the ball, flags and accumulator for random game events
-			srand(time(NULL));
-			Paddle player1(10, 40, 10, 40);
-			Paddle player2(SCREEN_WIDTH - 20, SCREEN_HEIGHT - 80, 10, 40);
-			player2.yVelocity /= 6;
-			Ball ball(SCREEN_WIDTH / 2 - 5, SCREEN_HEIGHT / 2 - 5, 10, 10);
-			bool sevenFlag = false;
-			bool zigzagFlag = false;
-			int zigzagTot = 0;
-
-			// Variable holds the game state, initialized to start
-			string gameState = "start";
+			// Set up the match. All of the game rules live in GameWorld
+			GameWorld world(seed);
+			world.player2Human = netplay;
+			world.fixedPoint = fixedPoint;
+			world.chaosBalls.spawn(chaosBalls);
+			if (replaying)
+			{
+				replay.setUp(world);
+			}
+			else if (arenaPath != NULL && !world.arena.load(arenaPath))
+			{
+				printf("Warning: Playing without bumpers!\n");
+			}
+			printf("Match seed: %llu\n", (unsigned long long)seed);
+
+			// The recording keeps the settings the match is played with
+			ReplayRecorder recorder;
+			if (recordPath != NULL)
+			{
+				recorder.open(recordPath, seed, world);
+			}
+
+			// Player 1's controls, sampled every frame and handed to the sim thread
+			InputSampler input;
+
+			// Follows paddle inputs to the frame that shows them
+			LatencyProbe latencyProbe;
+
+			// Frame timing, shown over the game with F1
+			PerfHud perfHud;
+			perfHud.init(window);
 
 			// Main loop flag
 			bool quit = false;
@@ -474,9 +668,111 @@ int main(int argc, char* args[])
 			// Event handler
 			SDL_Event event;
 
+			// Textures, surfaces and heap allocations made while the ball was in play (should all stay 0)
+			int playTextureCreations = 0;
+			int playSurfaceCreations = 0;
+			long long playAllocations = 0;
+
+			// What the court layer currently shows
+			int shownPlayer1Score = -1;
+			int shownPlayer2Score = -1;
+			GameState shownState = world.state;
+			int shownWinner = world.winningPlayer;
+
+			// Everything drawn in a frame is queued here and submitted in batches. Room for every chaos ball
+			// and particle is made now, so play doesn't allocate when effects get dense
+			RenderQueue renderQueue;
+			renderQueue.reserve(chaosBalls + PARTICLE_CAPACITY);
+			int maxDrawCalls = 0;
+
+			// Sparks, the ball's trail and score bursts, moved on by the time between frames drawn. The trail
+			// runs from where the ball was drawn last frame, and a score breaks it off
+			ParticlePool particles;
+			Uint64 particleTime = SDL_GetPerformanceCounter();
+			bool trailing = false;
+			float trailX = 0;
+			float trailY = 0;
+
+			// Recording, if asked for. The game plays on without it if it can't start
+			FrameCapture capture;
+			if (capturePath != NULL && !capture.open(renderer, capturePath, SCREEN_WIDTH, SCREEN_HEIGHT))
+			{
+				printf("Warning: Playing without capture!\n");
+			}
+
+			// The match runs on its own thread from here on. This thread only draws the frames it publishes
+			MatchControl match = { netplay, hosting, hello, &netSocket, &netSession, &replay, replaying, &recorder };
+			SimThread sim(world);
+			if (!sim.start(playTick, canPauseTicks, &match))
+			{
+				quit = true;
+			}
+			FrameState* frame = &sim.latestFrame();
+			long long shownTick = 0;
+
+			// Outside play nothing moves, so the loop only draws when the frame changes or something else
+			// invalidates it. The ball and paddles still move for a tick after play stops
+			bool redraw = true;
+			bool animating = true;
+			GameState drawnState = frame->state;
+			long long lastPlayTick = 0;
+
+			// Wakeups of this thread and the sim thread and frames drawn in the current second, and totals
+			// over the seconds spent idle
+			Uint64 wakeupWindowStart = SDL_GetPerformanceCounter();
+			int windowWakeups = 0;
+			int windowFrames = 0;
+			bool windowIdle = true;
+			double idleSeconds = 0;
+			int idleWakeups = 0;
+			int idleSimWakeups = 0;
+
 			// While application is running
 			while (!quit)
 			{
+				// Sleep until there's input, the sim thread changes state or it's time to check the audio
+				// again. The sim thread is told first, so a state change can't slip in before the wait
+				if (!animating && !redraw)
+				{
+					sim.setWaiting(true);
+					frame = &sim.latestFrame();
+					if (frame->state == drawnState)
+					{
+						SDL_WaitEventTimeout(NULL, IDLE_WAIT_MS);
+					}
+					sim.setWaiting(false);
+				}
+
+				windowWakeups++;
+				windowIdle = windowIdle && !animating;
+				Uint64 wakeupTime = SDL_GetPerformanceCounter();
+				if (wakeupTime - wakeupWindowStart >= SDL_GetPerformanceFrequency())
+				{
+					double seconds = (double)(wakeupTime - wakeupWindowStart) / SDL_GetPerformanceFrequency();
+					int simWakeups = sim.takeWakeups();
+					if (reportWakeups)
+					{
+						printf("Main loop: %.1f wakeups/s, %.1f frames/s, sim thread: %.1f wakeups/s%s\n", windowWakeups / seconds,
+							windowFrames / seconds, simWakeups / seconds, windowIdle ? " (idle)" : "");
+					}
+					if (windowIdle)
+					{
+						idleSeconds += seconds;
+						idleWakeups += windowWakeups;
+						idleSimWakeups += simWakeups;
+					}
+					wakeupWindowStart = wakeupTime;
+					windowWakeups = 0;
+					windowFrames = 0;
+					windowIdle = true;
+				}
+
+				perfHud.beginFrame();
+				int texturesBefore = renderStats.texturesCreated;
+				int drawCallsBefore = renderStats.drawCalls;
+				int surfacesBefore = renderStats.surfacesCreated;
+				long long allocationsBefore = allocationCount();
+
 				// Handle events on queue
 				while (SDL_PollEvent(&event) != 0)
 				{
@@ -486,275 +782,278 @@ int main(int argc, char* args[])
 						quit = true;
 					}
 
-					// User presses a key
-					else if (event.type == SDL_KEYDOWN)
-					{   // User presses either enter/return key, change the game state
-						if (event.key.keysym.sym == SDLK_RETURN || event.key.keysym.sym == SDLK_KP_ENTER)
-						{
-							if (gameState == "start")
-							{
-								gameState = "serve";
-							}
-							else if (gameState == "serve")
-							{
-								gameState = "play";
-							}
-							else if (gameState == "done")
-							{
-								gameState = "serve";
-								ball.reset();
-								player1Score = 0;
-								player2Score = 0;
-								servingPlayer = 1;
-								sevenFlag = false;
-								player1.height = 40;
-								player2.height = 40;
-							}
-						}
-						// Bal is in play
-						if (gameState == "play")
-						{
-							if (event.key.keysym.sym == SDLK_s)
-							{
-								player1.y = fmin(SCREEN_HEIGHT - player1.height, player1.y + player1.yVelocity);
-							}
-							else if (event.key.keysym.sym == SDLK_w)
-							{
-								player1.y = fmax(0, player1.y - player1.yVelocity);
-							}
-						}
+					// The renderer threw away the contents of render targets, so the court has to be redrawn
+					else if (event.type == SDL_RENDER_TARGETS_RESET)
+					{
+						courtLayer.invalidate();
+						redraw = true;
 					}
 
-				}
-
-				// Update game even if no keydown
-				if (gameState == "play")
-				{   // If there is no zig zag serves, the ball keeps moving normally
-					if (!zigzagFlag)
+					// The window was uncovered or changed, and has to be drawn again
+					else if (event.type == SDL_WINDOWEVENT)
 					{
-						ball.x += ball.xVelocity;
-						ball.y += ball.yVelocity;
-					}
-					else
-					{   // After moving in its direction 20 times, it reverses, giving a zigzag pattern
-						if (zigzagTot < 20 * ball.height)
-						{
-							ball.x += ball.xVelocity;
-							ball.y += 2 * ball.yVelocity;
-							zigzagTot += ball.height;
-						}
-						else
-						{
-							ball.yVelocity *= -1;
-							zigzagTot = 0;
-						}
+						redraw = true;
 					}
 
-					if (ball.collides(player1))
+					// User presses either enter/return key or A/Start on a controller, change the game state
+					else if ((event.type == SDL_KEYDOWN && (event.key.keysym.sym == SDLK_RETURN || event.key.keysym.sym == SDLK_KP_ENTER))
+						|| input.isAdvanceButton(event))
 					{
-						// Play sound
-						Mix_PlayChannel(-1, player1sound, 0);
-
-						// Turn off zigzag serve if player1 hits it
-						zigzagFlag = false;
-
-						// Move ball on collision in front of paddle. Several collisions happen when the ball hits the top of the paddle
-						ball.x = player1.x + player1.width;
-
-						// So the velocity doesn't overflow past the maximum double, otherwise increase its speed
-						if (ball.xVelocity > DBL_MAX)
-						{
-							ball.xVelocity = -DBL_MAX;
-						}
-						else
-						{
-							ball.xVelocity *= -1.05;
-						}
-
-						// Randomize yVelocity of ball and reverse its direction when collision occurs
-						if (ball.yVelocity < 0)
-						{
-							ball.yVelocity = -.1 * (rand() % 21);
-						}
-						else
-						{
-							ball.yVelocity = .1 * (rand() % 21);
-						}
-
-
+						sim.pressAdvance();
 					}
-					if (ball.collides(player2))
+
+					// Toggle the performance overlay
+					else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F1)
 					{
-						// Play sound
-						Mix_PlayChannel(-1, player2sound, 0);
-
-						ball.x = player2.x - player2.width;
-
-						// Player 2 will sometimes serve the ball in a zigzag and speed it up after player1 scores 3 
-						if (player1Score > 2 && !(rand() % 5))
-						{
-							zigzagFlag = true;
-							ball.xVelocity *= 1.5;
-							ball.yVelocity *= 1.5;
-						}
-						// So the velocity doesn't overflow
-						if (ball.xVelocity > DBL_MAX)
-						{
-							ball.xVelocity = -DBL_MAX;
-						}
-						else
-						{
-							ball.xVelocity *= -1.05;
-						}
-
-						if (ball.yVelocity < 0)
-						{
-							ball.yVelocity = -.1 * (rand() % 21);
-						}
-						else
-						{
-							ball.yVelocity = .1 * (rand() % 21);
-						}
-
-						// Player2 gets a random velocity divided by it to make the AI have a variable skill. Not too good or bad.
-						player2.yVelocity = PADDLE_SPEED / (6 + rand() % 5);
+						perfHud.toggle();
+						redraw = true;
 					}
 
-					// If the ball hits the top of screen, reverse its direction
-					if (ball.y <= 0)
+					// Dump the trace of the last minute or so of play
+					else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F2)
 					{
-						// Play sound
-						Mix_PlayChannel(-1, wallhitSound, 0);
-
-						ball.y = 0;
-						ball.yVelocity *= -1;
-						
+						traceWrite("trace.json");
 					}
 
-					// If the ball hits the bottom of screen, reverse its direction
-					if (ball.y >= SCREEN_HEIGHT - ball.height)
+					// Timestamp paddle inputs so we can see how long they take to reach the screen
+					else if (frame->state == STATE_PLAY && input.isPaddleInput(event))
 					{
-						// Play sound
-						Mix_PlayChannel(-1, wallhitSound, 0);
-
-						ball.y = SCREEN_HEIGHT - ball.height;
-						ball.yVelocity *= -1;
+						latencyProbe.inputArrived(event.common.timestamp);
 					}
 
-					// Player1 scores
-					if (ball.x >= SCREEN_WIDTH)
-					{
-						// Play sound
-						Mix_PlayChannel(-1, player1score, 0);
+					// Controllers plugged in or removed
+					input.handleEvent(event);
+				}
 
-						player1Score += 1;
-						ball.reset();
+				// Finish anything the loader threads are done with. Textures are only created on this thread
+				int loadedJob = loader.poll();
+				if (loadedJob != -1)
+				{
+					if (!loader.succeeded(loadedJob) || (loadedJob == fontJob && !textAtlas.upload(renderer)))
+					{
+						printf("Failed to load media!\n");
+						quit = true;
 					}
-
-					// Player2 scores. Turn off zigzag flag
-					if (ball.x <= 0)
+					else if (loadedJob == fontJob)
 					{
-						// Play sound
-						Mix_PlayChannel(-1, player2score, 0);
-
-						player2Score += 1;
-						zigzagFlag = false;
-						ball.reset();
+						// The court was drawn without text until now
+						courtLayer.invalidate();
+					}
+					else if (loadedJob == soundJob)
+					{
+						soundsReady = true;
 					}
 
-					if (player1Score == 10)
+					if (loader.isDone())
 					{
-						// Play sound
-						Mix_PlayChannel(-1, player1win, 0);
+						loader.printTimeline();
+					}
+				}
 
-						winningPlayer = 1;
-						gameState = "done";
+				// If audio keeps underrunning the device reopens with a bigger buffer, which may change its format
+				if (soundsReady && audioDevice.update())
+				{
+					soundBank.load(audioDevice, assetPack);
+				}
+				perfHud.mark(PHASE_EVENTS);
+
+				// The sim thread reads the paddle control on its next tick
+				latencyProbe.inputSent(sim.setPlayer1Axis(input.samplePlayer1Axis()));
+
+				// Take the latest tick the sim thread finished, and play the sounds of every tick since the last frame.
+				// The probe only counts the frame once its tick has read the control carrying the input
+				frame = &sim.latestFrame();
+				if (frame->tick != shownTick)
+				{
+					latencyProbe.tickConsumed(frame->inputSequence, frame->inputTime);
+					shownTick = frame->tick;
+				}
+				// Effects are spawned after the particles move, so the frame's spawn budget covers them
+				Uint64 now = SDL_GetPerformanceCounter();
+				particles.update((float)fmin((double)(now - particleTime) / SDL_GetPerformanceFrequency(), 0.1));
+				particleTime = now;
+				GameEvent gameEvent;
+				while (sim.popEvent(gameEvent))
+				{
+					if (soundsReady)
+					{
+						playSound(gameEvent.type);
 					}
-					else if (player2Score == 10)
+					particles.addEffect(gameEvent);
+					if (gameEvent.type == EVENT_PLAYER1_SCORE || gameEvent.type == EVENT_PLAYER2_SCORE)
 					{
-						// Play sound
-						Mix_PlayChannel(-1, player2win, 0);
-
-						winningPlayer = 2;
-						gameState = "done";
+						trailing = false;
 					}
+				}
+				perfHud.mark(PHASE_SIM);
 
-					//  AI for player 2
-					if (ball.xVelocity > 0)
+				// Skip the frame if nothing on screen would change. Loading and capturing keep the loop at full rate
+				if (frame->state == STATE_PLAY)
+				{
+					lastPlayTick = frame->tick;
+				}
+				if (frame->state != drawnState)
+				{
+					drawnState = frame->state;
+					redraw = true;
+				}
+				animating = frame->state == STATE_PLAY || frame->tick <= lastPlayTick + 1 || particles.getCount() > 0
+					|| !loader.isDone() || capture.isOpen();
+				if (!animating && !redraw)
+				{
+					continue;
+				}
+				redraw = false;
+				windowFrames++;
+
+				// How far the frame is between the last tick and the next one
+				double alpha = frame->alpha(SDL_GetPerformanceCounter(), sim.getTickLength());
+
+				// Redraw the court layer only when something on it changed. This switches render targets, so do it before drawing the frame
+				if (courtLayer.isReady())
+				{
+					if (frame->player1Score != shownPlayer1Score || frame->player2Score != shownPlayer2Score
+						|| frame->state != shownState || frame->winningPlayer != shownWinner)
+					{
+						courtLayer.invalidate();
+						shownPlayer1Score = frame->player1Score;
+						shownPlayer2Score = frame->player2Score;
+						shownState = frame->state;
+						shownWinner = frame->winningPlayer;
+					}
+					if (courtLayer.isDirty())
 					{
-							// If midpoint of paddle isn't over midpoint of ball
-							if (player2.y + player2.height / 2 > ball.y + ball.height / 2)
-							{
-								player2.y = fmax(0, player2.y - player2.yVelocity);
-							}
-							else if (player2.y + player2.height / 2 < ball.y + ball.height / 2)
-							{
-								player2.y = fmin(SCREEN_HEIGHT - player2.height, player2.y + player2.yVelocity);
-							}
-				
-						// Randomly reverse at midpoint of screen when score hits 6
-						if (player1Score > 5 && ball.x - ball.width / 2 > SCREEN_WIDTH / 2  
-							&& ball.x < SCREEN_WIDTH / 2 + ball.width && !(rand() % 7))
-						{
-							
-							ball.xVelocity *= -1.05;
-						}
-
-						// When score hits 8, player1 gets smaller and player 2 gets bigger.
-						// Flag ensures this block of code executes only once
-						if (!sevenFlag && player1Score > 7)
-						{
-							sevenFlag == true;
-							player1.height = 25;
-							player2.height = 60;
-						}
+						courtLayer.beginRebuild(renderer);
+						drawCourt(renderQueue, *frame, world.arena);
+						renderQueue.flush(renderer);
+						courtLayer.endRebuild(renderer);
 					}
 				}
-					
+				perfHud.mark(PHASE_TEXT);
+
+				// When recording, the frame is drawn into the capture's target instead of the window
+				if (capture.isOpen())
+				{
+					capture.beginFrame(renderer);
+				}
+
 				// Clear screen
 				SDL_SetRenderDrawColor(renderer, 0x00, 0x00, 0x00, 0x00);
 				SDL_RenderClear(renderer);
 
-				// Set UI message. loadMedia() set message already if gameState == "start"
-				if (gameState == "serve")
+				// Everything that isn't moving, in one copy
+				if (courtLayer.isReady())
+				{
+					courtLayer.render(renderQueue);
+				}
+				else
+				{
+					drawCourt(renderQueue, *frame, world.arena);
+				}
+
+				// Render balls and paddles where they are between ticks
+				frame->chaosBalls.render(renderQueue, alpha);
+				frame->ball.render(renderQueue, alpha);
+
+				// The trail behind the ball is brighter and longer the faster it goes. Every particle is one batch
+				if (frame->state == STATE_PLAY)
 				{
-					string tmpMessage = "Player 1's serve. Press Enter.";
-					msgTexture.loadFromRenderedText(tmpMessage, textColor, messageFont);
+					const Ball& ball = frame->ball;
+					float ballX = (float)(ball.prevX + (ball.x - ball.prevX) * alpha + ball.width / 2);
+					float ballY = (float)(ball.prevY + (ball.y - ball.prevY) * alpha + ball.height / 2);
+					if (trailing)
+					{
+						particles.addTrail(trailX, trailY, ballX, ballY, (float)sqrt(ball.xVelocity * ball.xVelocity + ball.yVelocity * ball.yVelocity));
+					}
+					trailX = ballX;
+					trailY = ballY;
+					trailing = true;
 				}
-				else if (gameState == "done")
+				else
 				{
-					string tmpMessage = "Player " + to_string(winningPlayer) + " wins! Press Enter to restart";
-					msgTexture.loadFromRenderedText(tmpMessage, textColor, messageFont);
+					trailing = false;
 				}
-				// Display UI message, e.g. "Press enter" or "Player 1 wins!" No message during play.
-				if (gameState != "play")
+				particles.render(renderQueue);
+				frame->player1.render(renderQueue, alpha);
+				frame->player2.render(renderQueue, alpha);
+
+				// The recording gets the frame without the overlay, which is drawn over it on the window
+				int drawCalls = 0;
+				if (capture.isOpen())
 				{
-					msgTexture.render(SCREEN_WIDTH / 2 - msgTexture.getWidth() / 2, 80);
+					drawCalls = renderQueue.flush(renderer);
+					capture.endFrame(renderer);
 				}
+				perfHud.render(renderQueue, textAtlas, messageFace);
 
-				// Render title of game
-				titleTexture.render((SCREEN_WIDTH - titleTexture.getWidth()) / 2, (SCREEN_HEIGHT - titleTexture.getHeight()) / 20);
-				
-				// Display score by loading text into texture and rendering it
-				p1Texture.loadFromRenderedText(to_string(player1Score), textColor, scoreFont);
-				p2Texture.loadFromRenderedText(to_string(player2Score), textColor, scoreFont);
+				// Submit the whole frame in as few draw calls as possible, then update screen
+				drawCalls += renderQueue.flush(renderer);
+				if (drawCalls > maxDrawCalls)
+				{
+					maxDrawCalls = drawCalls;
+				}
+				perfHud.mark(PHASE_RENDER);
+				SDL_RenderPresent(renderer);
+				loader.firstFrameShown();
+				latencyProbe.presented();
+				perfHud.mark(PHASE_PRESENT);
+				int frameAllocations = (int)(allocationCount() - allocationsBefore);
+				perfHud.endFrame(renderStats.texturesCreated - texturesBefore, renderStats.drawCalls - drawCallsBefore, frameAllocations);
+
+				// Count any texture, surface or heap churn that happened while the ball was moving. This
+				// includes the sim thread's ticks, which run during the frame
+				if (frame->state == STATE_PLAY)
+				{
+					playTextureCreations += renderStats.texturesCreated - texturesBefore;
+					playSurfaceCreations += renderStats.surfacesCreated - surfacesBefore;
+					playAllocations += frameAllocations;
+				}
+			}
 
-				p1Texture.render(SCREEN_WIDTH / 2  - 100, (SCREEN_HEIGHT - p1Texture.getHeight()) / 3);
-				p2Texture.render(SCREEN_WIDTH / 2 + 100 - p2Texture.getWidth(), (SCREEN_HEIGHT - p2Texture.getHeight()) / 3);
+			// Hand the world back from the sim thread before reporting on it, and finish writing the recording
+			sim.stop();
+			capture.close(renderer);
 
-				// Render ball and paddles
-				ball.render(renderer);
-				player1.render(renderer);
-				player2.render(renderer);
+			printf("Textures created during play: %d\n", playTextureCreations);
+			printf("Surfaces created during play: %d\n", playSurfaceCreations);
+			if (ALLOCATIONS_TRACKED)
+			{
+				printf("Heap allocations during play: %lld\n", playAllocations);
+			}
+			else
+			{
+				printf("Heap allocations during play: not counted, build as Debug or with -DALLOC_TRACKER=ON\n");
+			}
+			printf("Most draw calls in a frame: %d\n", maxDrawCalls);
+			printf("Court layer redraws: %d\n", courtLayer.getRebuildCount());
+			printf("Particles dropped over the pool or frame budget: %lld\n", particles.getDropped());
+			if (idleSeconds > 0)
+			{
+				printf("While idle: main loop %.1f wakeups/s, sim thread %.1f wakeups/s over %.0f s\n", idleWakeups / idleSeconds,
+					idleSimWakeups / idleSeconds, idleSeconds);
+			}
+			latencyProbe.printReport();
+			audioDevice.printReport();
+			capture.printReport();
+			if (netplay)
+			{
+				netSession.printReport();
+			}
+			perfHud.writeSummary("perf_summary.csv");
+#ifdef TRACE_ENABLED
+			traceWrite("trace.json");
+#endif
 
-				// Update screen
-				SDL_RenderPresent(renderer);
+			if (recorder.isOpen())
+			{
+				recorder.close(world);
 			}
 		}
 	}
 
-	// Free resources and close SDL
+	// Let any loading still going finish, then free resources and close SDL
+	loader.waitAll();
 	close();
 
 	return 0;
-}
\ No newline at end of file
+}
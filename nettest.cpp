@@ -0,0 +1,264 @@
+// Loopback test of rollback netplay. Two sessions play a match against each other over UDP on this
+// machine, each driven by a bot, with latency, jitter and loss added to every packet. When the ticks run
+// out both sides have to have ended up in exactly the same state, with points scored. Reports how deep
+// rollbacks went and what replaying cost.
+//   nettest [-ticks N] [-latency MS] [-jitter MS] [-loss PERCENT] [-seed N]
+#include "GameWorld.h"
+#include "NetSession.h"
+#include "UdpSocket.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Ticks played when no count is given: five minutes of play
+const int DEFAULT_TICKS = TICKS_PER_SECOND * 60 * 5;
+
+// Real time after the last tick for the two sides to catch up with each other's inputs
+const int SETTLE_TICKS = TICKS_PER_SECOND * 10;
+
+// Chance in a hundred that a bot lets the ball past, rolled each time the ball comes at it. Without
+// misses neither side ever scores, and a match that stays 0-0 tests little
+const int BOT_MISS_PERCENT = 25;
+
+// A packet held back to fake the network
+struct DelayedPacket
+{
+	double arrival;
+	int size;
+	uint8_t data[NET_MAX_PACKET];
+};
+
+// One side of the match: its copy of the game, its session and its socket, plus the packets it has
+// sent that the fake network hasn't delivered yet
+struct Side
+{
+	Side(int player, uint64_t seed) : world(seed), session(player), player(player), bot(seed, 1 + player)
+	{
+		world.player2Human = true;
+		coming = false;
+		missing = false;
+	}
+
+	GameWorld world;
+	NetSession session;
+	UdpSocket socket;
+	vector<DelayedPacket> inFlight;
+	int player;
+
+	// The bot's own random numbers, whether the ball was coming at it last tick, and whether it has
+	// decided to miss this time
+	Rng bot;
+	bool coming;
+	bool missing;
+};
+
+// Bot for either side: the stick toward the ball when it is coming, unless it rolled a miss for this
+// approach. Its inputs are sent like a player's, so the misses don't need to be the same on both sides
+double botAxis(Side& side)
+{
+	const GameWorld& world = side.world;
+	const Paddle& paddle = side.player == 1 ? world.player1 : world.player2;
+	bool coming = side.player == 1 ? world.ball.xVelocity < 0 : world.ball.xVelocity > 0;
+	if (coming && !side.coming)
+	{
+		side.missing = side.bot.below(100) < BOT_MISS_PERCENT;
+	}
+	side.coming = coming;
+
+	double offset = world.ball.y + world.ball.height / 2 - (paddle.y + paddle.height / 2);
+	return coming && !side.missing ? fmax(-1, fmin(1, offset / PLAYER1_SPEED)) : 0;
+}
+
+// Waits a moment for a hello to come in on the loopback
+bool receiveHello(UdpSocket& socket, NetHello& hello)
+{
+	uint8_t data[NET_MAX_PACKET];
+	for (int i = 0; i < 100; i++)
+	{
+		int size = socket.receive(data, sizeof(data));
+		if (size > 0)
+		{
+			return NetSession::readHello(data, size, hello);
+		}
+		this_thread::sleep_for(chrono::milliseconds(10));
+	}
+	return false;
+}
+
+int main(int argc, char* argv[])
+{
+	int ticks = DEFAULT_TICKS;
+	double latency = 60;
+	double jitter = 20;
+	double loss = 5;
+	uint64_t seed = 1;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-ticks") == 0 && i + 1 < argc)
+		{
+			ticks = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-latency") == 0 && i + 1 < argc)
+		{
+			latency = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-jitter") == 0 && i + 1 < argc)
+		{
+			jitter = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-loss") == 0 && i + 1 < argc)
+		{
+			loss = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-seed") == 0 && i + 1 < argc)
+		{
+			seed = strtoull(argv[++i], NULL, 10);
+		}
+		else
+		{
+			printf("Unknown option %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	Side player1(1, seed);
+	Side player2(2, seed);
+	Side* sides[2] = { &player1, &player2 };
+	if (!player1.socket.open(0) || !player2.socket.open(0)
+		|| !player1.socket.connect("127.0.0.1", player2.socket.getPort())
+		|| !player2.socket.connect("127.0.0.1", player1.socket.getPort()))
+	{
+		return 1;
+	}
+	printf("latency: %.0fms, jitter: %.0fms, loss: %.0f%%\n", latency, jitter, loss);
+
+	// The handshake, as the game does it: player 2 says hello, player 1 answers with the seed. Both check
+	// the other plays with the same settings
+	NetHello hello = { seed, false, player1.world.arena.hash() };
+	NetHello received = {};
+	uint8_t data[NET_MAX_PACKET];
+	player2.socket.send(data, NetSession::writeHello(data, hello));
+	if (!receiveHello(player1.socket, received) || !NetSession::helloAgrees(hello, received))
+	{
+		printf("Player 1 didn't take player 2's hello!\n");
+		return 1;
+	}
+	player1.socket.send(data, NetSession::writeHello(data, hello));
+	if (!receiveHello(player2.socket, received) || !NetSession::helloAgrees(hello, received) || received.seed != seed)
+	{
+		printf("Player 2 didn't take player 1's hello!\n");
+		return 1;
+	}
+
+	// A side with other settings has to be refused
+	NetHello other = hello;
+	other.fixedPoint = true;
+	printf("Expecting a refusal: ");
+	if (NetSession::helloAgrees(hello, other))
+	{
+		printf("A hello with -fixed was taken by a side without it!\n");
+		return 1;
+	}
+
+	// The fake network's own random numbers, separate from the match's
+	Rng network(seed, 1);
+	double tickMs = 1000.0 / TICKS_PER_SECOND;
+
+	int tick = 0;
+	for (; tick < ticks + SETTLE_TICKS; tick++)
+	{
+		double now = tick * tickMs;
+		bool playing = tick < ticks;
+
+		for (Side* side : sides)
+		{
+			// Both sides play the same number of ticks, then only trade packets until they agree
+			if (side->session.getTick() < ticks)
+			{
+				side->session.advance(side->world, botAxis(*side), side->world.state != STATE_PLAY);
+			}
+
+			// Every tick sends a packet. The network drops some and delays the rest by latency plus up to
+			// jitter either way, so later packets can overtake earlier ones
+			DelayedPacket packet;
+			packet.size = side->session.writeInputs(packet.data);
+			bool lost = playing && network.below(10000) < loss * 100;
+			if (!lost)
+			{
+				packet.arrival = now + latency + jitter * (network.below(2001) - 1000) / 1000.0;
+				side->inFlight.push_back(packet);
+			}
+
+			// Hand the packets that have arrived to the socket
+			for (size_t i = 0; i < side->inFlight.size();)
+			{
+				if (side->inFlight[i].arrival <= now)
+				{
+					side->socket.send(side->inFlight[i].data, side->inFlight[i].size);
+					side->inFlight.erase(side->inFlight.begin() + i);
+				}
+				else
+				{
+					i++;
+				}
+			}
+		}
+
+		for (Side* side : sides)
+		{
+			uint8_t data[NET_MAX_PACKET];
+			int size;
+			while ((size = side->socket.receive(data, sizeof(data))) > 0)
+			{
+				side->session.readInputs(data, size);
+			}
+		}
+
+		if (!playing && player1.session.getRemoteTick() >= ticks && player2.session.getRemoteTick() >= ticks)
+		{
+			break;
+		}
+	}
+
+	bool agree = true;
+	for (Side* side : sides)
+	{
+		side->session.rollback(side->world);
+		printf("\nPlayer %d:\n", side->player);
+		side->session.printReport();
+		if (side->session.getTick() != ticks || side->session.getRemoteTick() < ticks)
+		{
+			printf("Never caught up with the other side!\n");
+			agree = false;
+		}
+	}
+
+	uint64_t checksum1 = player1.world.checksum();
+	uint64_t checksum2 = player2.world.checksum();
+	printf("\nScore %d-%d after %d ticks\n", player1.world.player1Score, player1.world.player2Score, ticks);
+	if (player1.world.player1Score != player2.world.player1Score || player1.world.player2Score != player2.world.player2Score)
+	{
+		printf("Player 2 saw the score as %d-%d!\n", player2.world.player1Score, player2.world.player2Score);
+		agree = false;
+	}
+	if (player1.world.player1Score + player1.world.player2Score == 0 && player1.world.winningPlayer == 0)
+	{
+		printf("Nobody scored, so the match tested nothing!\n");
+		agree = false;
+	}
+	if (checksum1 != checksum2)
+	{
+		printf("Desync! Player 1 ended at %016llx, player 2 at %016llx\n", (unsigned long long)checksum1, (unsigned long long)checksum2);
+		agree = false;
+	}
+	else
+	{
+		printf("Both sides ended at %016llx\n", (unsigned long long)checksum1);
+	}
+	return agree ? 0 : 1;
+}
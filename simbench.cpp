@@ -0,0 +1,333 @@
+// Headless simulation benchmark. Plays matches with a simple bot in player 1's seat against
+// the built in AI and reports how many ticks per second the game rules can run.
+//   simbench [ticks] [-record FILE]   bot matches, optionally saved as a replay
+//   simbench -replay FILE             times a recorded match instead, and checks it still plays the same
+//   simbench -fixed ...               plays the matches or the replay with fixed point physics
+//   simbench -chaos BALLS             times the chaos ball kernels with that many balls
+//   simbench -arena                   times bumper sweeps through the grid against testing every bumper
+//   simbench -stuckcheck FILE         plays matches in that arena and fails if the ball ever stops crossing
+#include "GameWorld.h"
+#include "Replay.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <cmath>
+#include <chrono>
+
+using namespace std;
+
+// Ticks simulated when no count is given on the command line
+const long long DEFAULT_TICKS = 10000000;
+
+// Player 1 bot: holds the stick toward the ball. It only reacts once the ball is coming at it
+// in its own half, so fast balls get past it like they would a person
+GameInputs botInputs(const GameWorld& world)
+{
+	GameInputs inputs;
+	if (world.state != STATE_PLAY)
+	{
+		inputs.advance = true;
+	}
+	else if (world.ball.xVelocity < 0 && world.ball.x < SCREEN_WIDTH / 2)
+	{
+		double paddleMid = world.player1.y + world.player1.height / 2;
+		double ballMid = world.ball.y + world.ball.height / 2;
+		if (ballMid > paddleMid + PLAYER1_SPEED / 2)
+		{
+			inputs.player1Axis = 1;
+		}
+		else if (ballMid < paddleMid - PLAYER1_SPEED / 2)
+		{
+			inputs.player1Axis = -1;
+		}
+	}
+	return inputs;
+}
+
+// Ball ticks each kernel runs in the chaos benchmark
+const long long CHAOS_BALL_TICKS = 200000000;
+
+// Steps a pool of chaos balls between the paddles where a match starts, once with every kernel the
+// CPU can run, and reports balls per millisecond. Every kernel has to finish in exactly the same state
+int benchChaos(int balls)
+{
+	GameWorld world(1);
+	Box paddle1 = world.player1.box();
+	Box paddle2 = world.player2.box();
+	long long ticks = balls > 0 ? max(1LL, CHAOS_BALL_TICKS / balls) : 0;
+
+	printf("balls: %d\n", balls);
+	printf("ticks: %lld\n", ticks);
+	uint64_t expected = 0;
+	bool agree = true;
+	for (int kernel = KERNEL_SCALAR; kernel <= BallPool::bestKernel(); kernel++)
+	{
+		BallPool pool(1);
+		pool.setKernel((BallKernel)kernel);
+		pool.spawn(balls);
+		long long hits = 0;
+
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		for (long long tick = 0; tick < ticks; tick++)
+		{
+			pool.storePrevious();
+			hits += pool.step(paddle1, paddle2);
+		}
+		double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+		// A tick has to fit in a 60Hz frame with room to spare for drawing
+		double msPerTick = seconds * 1000 / ticks;
+		printf("%s: %.0f balls/ms, %.4f ms/tick (%.1f%% of a 60Hz frame), %lld paddle hits\n",
+			BallPool::kernelName((BallKernel)kernel), balls * ticks / (seconds * 1000), msPerTick, msPerTick * 6, hits);
+
+		if (kernel == KERNEL_SCALAR)
+		{
+			expected = pool.checksum();
+		}
+		else if (pool.checksum() != expected)
+		{
+			printf("%s finished in a different state than scalar!\n", BallPool::kernelName((BallKernel)kernel));
+			agree = false;
+		}
+	}
+	return agree ? 0 : 1;
+}
+
+// Sweeps timed through the grid at each arena size. Testing every bumper is slower, so it gets fewer
+const int ARENA_SWEEPS = 1000000;
+const int ARENA_MIN_BRUTE_SWEEPS = 2000;
+
+// Share of the court the bumpers cover, whatever their count
+const double ARENA_COVER = 0.15;
+
+// Fills arenas of more and more bumpers at the same coverage and sweeps ball sized boxes through them
+// at ball speeds. Reports the cost of a sweep both ways. Both ways have to hit the same bumpers
+int benchArena()
+{
+	const int counts[] = { 16, 64, 256, 1024, 4096, 16384 };
+	bool agree = true;
+	for (int count : counts)
+	{
+		// Bumpers get smaller as there are more of them, half rectangles and half circles
+		Rng rng(count);
+		double size = sqrt(SCREEN_WIDTH * SCREEN_HEIGHT * ARENA_COVER / count);
+		Arena arena;
+		for (int i = 0; i < count; i++)
+		{
+			double w = size * (0.5 + rng.below(100) / 100.0);
+			double h = i % 2 == 0 ? size * (0.5 + rng.below(100) / 100.0) : w;
+			Bumper bumper = { i % 2 == 0 ? BUMPER_RECT : BUMPER_CIRCLE,
+				{ (double)rng.below(SCREEN_WIDTH), (double)rng.below(SCREEN_HEIGHT), w, h } };
+			arena.add(bumper);
+		}
+		arena.bake();
+
+		// Ball sized boxes anywhere on the court, moving at up to the ball's top speed both ways
+		int topSpeed = (int)MAX_BALL_SPEED;
+		vector<Box> boxes(ARENA_SWEEPS);
+		vector<double> dx(ARENA_SWEEPS), dy(ARENA_SWEEPS);
+		for (int i = 0; i < ARENA_SWEEPS; i++)
+		{
+			boxes[i] = { (double)rng.below(SCREEN_WIDTH), (double)rng.below(SCREEN_HEIGHT), 10, 10 };
+			dx[i] = rng.below(topSpeed * 2 + 1) - topSpeed;
+			dy[i] = rng.below(topSpeed * 2 + 1) - topSpeed;
+		}
+
+		SweepHit hit;
+		vector<int> gridHits(ARENA_SWEEPS);
+		vector<double> gridTimes(ARENA_SWEEPS);
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		for (int i = 0; i < ARENA_SWEEPS; i++)
+		{
+			gridHits[i] = arena.sweep(boxes[i], dx[i], dy[i], hit);
+			gridTimes[i] = hit.time;
+		}
+		double gridSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+		int bruteSweeps = max(ARENA_MIN_BRUTE_SWEEPS, ARENA_SWEEPS / count * 16);
+		bruteSweeps = min(bruteSweeps, ARENA_SWEEPS);
+		int hits = 0;
+		int mismatches = 0;
+		start = chrono::steady_clock::now();
+		for (int i = 0; i < bruteSweeps; i++)
+		{
+			int bumper = arena.sweepAll(boxes[i], dx[i], dy[i], hit);
+			if (bumper != gridHits[i] || (bumper != -1 && hit.time != gridTimes[i]))
+			{
+				mismatches++;
+			}
+			hits += bumper != -1;
+		}
+		double bruteSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+		printf("%5d bumpers: grid %.1f ns/sweep, every bumper %.1f ns/sweep, %.1f%% of sweeps hit\n", count,
+			gridSeconds * 1e9 / ARENA_SWEEPS, bruteSeconds * 1e9 / bruteSweeps, hits * 100.0 / bruteSweeps);
+		if (mismatches > 0)
+		{
+			printf("The grid missed %d of %d sweeps!\n", mismatches, bruteSweeps);
+			agree = false;
+		}
+	}
+	return agree ? 0 : 1;
+}
+
+// Matches the stuck ball check plays, each from its own seed, and the most ticks it gives one
+const int STUCK_CHECK_MATCHES = 300;
+const long long STUCK_CHECK_MATCH_TICKS = TICKS_PER_SECOND * 60 * 10;
+
+// Play without the ball crossing the net, touching a paddle or scoring for this long means it is stuck
+const long long STUCK_TICKS = TICKS_PER_SECOND * 30;
+
+// Plays bot matches in an arena and checks the ball keeps crossing the court. A ball that bumpers have
+// turned straight up or down only bounces between the walls, and the match can never end. A ball caught
+// between bumpers a while still crosses the net, so it isn't counted
+int checkStuck(const char* arenaPath, bool fixedPoint)
+{
+	long long ticks = 0;
+	for (int match = 0; match < STUCK_CHECK_MATCHES; match++)
+	{
+		GameWorld world(match + 1);
+		world.fixedPoint = fixedPoint;
+		if (!world.arena.load(arenaPath))
+		{
+			return 1;
+		}
+
+		long long idle = 0;
+		for (long long tick = 0; tick < STUCK_CHECK_MATCH_TICKS && world.state != STATE_DONE; tick++, ticks++)
+		{
+			bool left = world.ball.x + world.ball.width / 2 < SCREEN_WIDTH / 2;
+			world.step(botInputs(world));
+			bool crossed = left != (world.ball.x + world.ball.width / 2 < SCREEN_WIDTH / 2);
+			idle = world.state == STATE_PLAY && !crossed ? idle + 1 : 0;
+			for (int i = 0; i < world.eventCount; i++)
+			{
+				GameEventType type = world.events[i].type;
+				if (type == EVENT_PLAYER1_HIT || type == EVENT_PLAYER2_HIT || type == EVENT_PLAYER1_SCORE || type == EVENT_PLAYER2_SCORE)
+				{
+					idle = 0;
+				}
+			}
+			if (idle > STUCK_TICKS)
+			{
+				printf("Stuck ball in match %d at tick %lld: x velocity %g, y velocity %g\n", match + 1, tick,
+					world.ball.xVelocity, world.ball.yVelocity);
+				return 1;
+			}
+		}
+	}
+	printf("No stuck ball in %d matches, %lld ticks\n", STUCK_CHECK_MATCHES, ticks);
+	return 0;
+}
+
+int main(int argc, char* argv[])
+{
+	long long ticks = DEFAULT_TICKS;
+	const char* recordPath = NULL;
+	const char* replayPath = NULL;
+	int chaosBalls = 0;
+	bool arena = false;
+	const char* stuckArenaPath = NULL;
+	bool fixedPoint = false;
+
+	// Every option is read before any mode runs, so their order on the command line doesn't matter
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-fixed") == 0)
+		{
+			fixedPoint = true;
+		}
+		else if (strcmp(argv[i], "-replay") == 0 && i + 1 < argc)
+		{
+			replayPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "-chaos") == 0 && i + 1 < argc)
+		{
+			chaosBalls = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-arena") == 0)
+		{
+			arena = true;
+		}
+		else if (strcmp(argv[i], "-stuckcheck") == 0 && i + 1 < argc)
+		{
+			stuckArenaPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "-record") == 0 && i + 1 < argc)
+		{
+			recordPath = argv[++i];
+		}
+		else
+		{
+			// A bare number is the tick count, anything else is a mistake
+			char* end;
+			ticks = strtoll(argv[i], &end, 10);
+			if (*end != '\0' || ticks <= 0)
+			{
+				printf("Unknown option %s\n", argv[i]);
+				return 1;
+			}
+		}
+	}
+
+	if (replayPath != NULL)
+	{
+		return playReplayHeadless(replayPath, fixedPoint) ? 0 : 1;
+	}
+	if (chaosBalls > 0)
+	{
+		return benchChaos(chaosBalls);
+	}
+	if (arena)
+	{
+		return benchArena();
+	}
+	if (stuckArenaPath != NULL)
+	{
+		return checkStuck(stuckArenaPath, fixedPoint);
+	}
+
+	// Fixed seed so every run plays the same matches
+	GameWorld world(1);
+	world.fixedPoint = fixedPoint;
+	ReplayRecorder recorder;
+	if (recordPath != NULL && !recorder.open(recordPath, 1, world))
+	{
+		return 1;
+	}
+	long long matches = 0;
+	long long events = 0;
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (long long tick = 0; tick < ticks; tick++)
+	{
+		GameInputs inputs = botInputs(world);
+		recorder.record(inputs);
+		world.step(inputs);
+		events += world.eventCount;
+		for (int i = 0; i < world.eventCount; i++)
+		{
+			if (world.events[i].type == EVENT_PLAYER1_WIN || world.events[i].type == EVENT_PLAYER2_WIN)
+			{
+				matches++;
+			}
+		}
+	}
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	printf("ticks: %lld\n", ticks);
+	printf("matches: %lld\n", matches);
+	printf("events: %lld\n", events);
+	printf("seconds: %.3f\n", seconds);
+	printf("ticks/sec: %.0f\n", ticks / seconds);
+	printf("ns/tick: %.2f\n", seconds * 1e9 / ticks);
+	printf("checksum: %016llx\n", (unsigned long long)world.checksum());
+
+	if (recorder.isOpen() && !recorder.close(world))
+	{
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,286 @@
+// Self-play tuner for the difficulty curve. Plays AI against AI on every core, sweeping one difficulty
+// setting at a time with the rest left at the game's defaults, and writes player 1's win rate and the
+// rally lengths at every value as CSV.
+//   tuner [-matches N] [-threads N] [-seed N] [-skill TICKS ERROR] [-out FILE]
+// -matches is per swept value, -skill is the reaction delay and aim error of the AI in player 1's seat
+#include "GameWorld.h"
+#include "Trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Matches played at every swept value when no count is given
+const int DEFAULT_MATCHES = 2000;
+
+// Matches in one unit of work. Every batch has its own random stream, so the results are the same
+// whatever the thread count
+const int MATCHES_PER_BATCH = 50;
+
+// A match still going after ten minutes of play is stopped and counted as unfinished
+const long long MAX_MATCH_TICKS = TICKS_PER_SECOND * 60 * 10;
+
+// Share of a value's matches that may go unfinished before its row is flagged. Past this the win rate
+// only describes the matches that happened to end, and says little about the setting
+const double MAX_UNFINISHED_SHARE = 0.1;
+
+// Player 1's AI stands in for a good player. Its aim is off by just enough to miss now and then, besides
+// the points it loses to the difficulty tricks. Against the default curve it wins about three matches in
+// five, and fewer than one in fifty runs past the ten minute cap
+const AiSkill DEFAULT_PLAYER1_SKILL = { 8, 21 };
+
+// A difficulty setting and the values it is swept over
+struct Setting
+{
+	const char* name;
+	double first;
+	double last;
+	double step;
+	void (*apply)(DifficultyParams& difficulty, double value);
+};
+
+// Player 2 any faster or quicker to react than the lowest values here returns nearly every ball, and
+// those matches never end
+const Setting SETTINGS[] =
+{
+	{ "zigzag_score", 0, 9, 1, [](DifficultyParams& d, double v) { d.zigzagScore = (int)v; } },
+	{ "zigzag_odds", 1, 10, 1, [](DifficultyParams& d, double v) { d.zigzagOdds = (int)v; } },
+	{ "reverse_score", 0, 9, 1, [](DifficultyParams& d, double v) { d.reverseScore = (int)v; } },
+	{ "reverse_odds", 1, 12, 1, [](DifficultyParams& d, double v) { d.reverseOdds = (int)v; } },
+	{ "resize_score", 0, 9, 1, [](DifficultyParams& d, double v) { d.resizeScore = (int)v; } },
+	{ "ai_slowdown_min", 5, 12, 1, [](DifficultyParams& d, double v) { d.aiSlowdownMin = (int)v; } },
+	{ "ai_reaction_ticks", 6, 30, 3, [](DifficultyParams& d, double v) { d.aiSkill.reactionTicks = (int)v; } },
+	{ "ai_aim_error", 0, 40, 4, [](DifficultyParams& d, double v) { d.aiSkill.aimError = v; } },
+};
+
+// One value of one setting, and what its matches added up to
+struct SweepPoint
+{
+	const char* setting;
+	double value;
+	DifficultyParams difficulty;
+};
+
+struct Tally
+{
+	long long matches = 0;
+	long long player1Wins = 0;
+	long long unfinished = 0;
+	long long points = 0;
+	long long rallyHits = 0;
+	long long longestRally = 0;
+	long long ticks = 0;
+
+	void add(const Tally& other)
+	{
+		matches += other.matches;
+		player1Wins += other.player1Wins;
+		unfinished += other.unfinished;
+		points += other.points;
+		rallyHits += other.rallyHits;
+		longestRally = max(longestRally, other.longestRally);
+		ticks += other.ticks;
+	}
+};
+
+// Plays one match to the winning score. Player 1's AI reads the ball the same way player 2's does, and
+// plans again whenever the ball's course changes
+void playMatch(const DifficultyParams& difficulty, const AiSkill& player1Skill, Rng& rng, Tally& tally)
+{
+	uint64_t seed = (uint64_t)rng.next() << 32 | rng.next();
+	GameWorld world(seed, difficulty);
+	AiPlanner player1;
+	long long rally = 0;
+
+	long long tick = 0;
+	for (; tick < MAX_MATCH_TICKS && world.state != STATE_DONE; tick++)
+	{
+		GameInputs inputs;
+		inputs.advance = world.state != STATE_PLAY;
+		player1.plan(world.ball, world.zigzagFlag ? 2 : 1, world.player1, player1Skill, rng);
+		inputs.player1Axis = player1.move(world.player1, PLAYER1_SPEED) / PLAYER1_SPEED;
+
+		double xVelocity = world.ball.xVelocity;
+		double yVelocity = world.ball.yVelocity;
+		world.step(inputs);
+
+		bool wallOnly = true;
+		for (int i = 0; i < world.eventCount; i++)
+		{
+			GameEventType type = world.events[i].type;
+			wallOnly = wallOnly && type == EVENT_WALL_HIT;
+			if (type == EVENT_PLAYER1_HIT || type == EVENT_PLAYER2_HIT)
+			{
+				rally++;
+			}
+			else if (type == EVENT_PLAYER1_SCORE || type == EVENT_PLAYER2_SCORE)
+			{
+				tally.points++;
+				tally.rallyHits += rally;
+				tally.longestRally = max(tally.longestRally, rally);
+				rally = 0;
+			}
+		}
+		if (!wallOnly || world.ball.xVelocity != xVelocity || world.ball.yVelocity != yVelocity)
+		{
+			player1.replan(!wallOnly || world.eventCount == 0);
+		}
+	}
+
+	tally.matches++;
+	tally.ticks += tick;
+	if (world.state != STATE_DONE)
+	{
+		tally.unfinished++;
+	}
+	else if (world.winningPlayer == 1)
+	{
+		tally.player1Wins++;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	int matches = DEFAULT_MATCHES;
+	int threads = max(1u, thread::hardware_concurrency());
+	uint64_t seed = 1;
+	AiSkill player1Skill = DEFAULT_PLAYER1_SKILL;
+	const char* outPath = "difficulty_sweep.csv";
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-matches") == 0 && i + 1 < argc)
+		{
+			matches = max(1, atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc)
+		{
+			threads = max(1, atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-seed") == 0 && i + 1 < argc)
+		{
+			seed = strtoull(argv[++i], NULL, 10);
+		}
+		else if (strcmp(argv[i], "-skill") == 0 && i + 2 < argc)
+		{
+			player1Skill.reactionTicks = atoi(argv[++i]);
+			player1Skill.aimError = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-out") == 0 && i + 1 < argc)
+		{
+			outPath = argv[++i];
+		}
+		else
+		{
+			printf("Unknown option %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	// The defaults first, as a baseline, then every value of every setting
+	vector<SweepPoint> points;
+	points.push_back({ "default", 0, DEFAULT_DIFFICULTY });
+	for (const Setting& setting : SETTINGS)
+	{
+		for (double value = setting.first; value <= setting.last; value += setting.step)
+		{
+			SweepPoint point = { setting.name, value, DEFAULT_DIFFICULTY };
+			setting.apply(point.difficulty, value);
+			points.push_back(point);
+		}
+	}
+
+	// Split every point into batches. Each batch has its own tally, so the workers share nothing but
+	// the counter handing out the next batch
+	int batchesPerPoint = (matches + MATCHES_PER_BATCH - 1) / MATCHES_PER_BATCH;
+	int batchCount = (int)points.size() * batchesPerPoint;
+	vector<Tally> batches(batchCount);
+	atomic<int> nextBatch(0);
+
+	printf("Sweeping %d values with %d matches each on %d threads\n", (int)points.size(), matches, threads);
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+	vector<thread> workers;
+	for (int t = 0; t < threads; t++)
+	{
+		workers.push_back(thread([&]()
+		{
+			TRACE_THREAD("worker");
+			for (int batch = nextBatch++; batch < batchCount; batch = nextBatch++)
+			{
+				const SweepPoint& point = points[batch / batchesPerPoint];
+				int first = batch % batchesPerPoint * MATCHES_PER_BATCH;
+				int count = min(MATCHES_PER_BATCH, matches - first);
+
+				// Tally locally and store once, so neighbouring batches don't fight over a cache line
+				TRACE_ZONE("batch");
+				Rng rng(seed, batch);
+				Tally tally;
+				for (int match = 0; match < count; match++)
+				{
+					playMatch(point.difficulty, player1Skill, rng, tally);
+				}
+				batches[batch] = tally;
+			}
+		}));
+	}
+	for (thread& worker : workers)
+	{
+		worker.join();
+	}
+
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	long long totalMatches = 0;
+	long long totalTicks = 0;
+	for (const Tally& batch : batches)
+	{
+		totalMatches += batch.matches;
+		totalTicks += batch.ticks;
+	}
+	printf("seconds: %.2f\n", seconds);
+	printf("matches/sec: %.0f\n", totalMatches / seconds);
+	printf("ticks/sec: %.0f\n", totalTicks / seconds);
+
+	FILE* file = fopen(outPath, "w");
+	if (file == NULL)
+	{
+		printf("Unable to write %s!\n", outPath);
+		return 1;
+	}
+	// The win rate is over finished matches only. An unfinished match has no winner, so counting it as a
+	// loss would drag the rate down wherever matches run long
+	fprintf(file, "setting,value,matches,finished,unfinished,player1_win_rate,mean_rally,longest_rally,mean_match_seconds\n");
+	int flagged = 0;
+	for (size_t p = 0; p < points.size(); p++)
+	{
+		Tally tally;
+		for (int b = 0; b < batchesPerPoint; b++)
+		{
+			tally.add(batches[p * batchesPerPoint + b]);
+		}
+		long long finished = tally.matches - tally.unfinished;
+		fprintf(file, "%s,%g,%lld,%lld,%lld,%.4f,%.2f,%lld,%.1f\n", points[p].setting, points[p].value, tally.matches,
+			finished, tally.unfinished, finished > 0 ? (double)tally.player1Wins / finished : 0,
+			tally.points > 0 ? (double)tally.rallyHits / tally.points : 0, tally.longestRally,
+			(double)tally.ticks / tally.matches / TICKS_PER_SECOND);
+
+		if (tally.unfinished > tally.matches * MAX_UNFINISHED_SHARE)
+		{
+			printf("%s=%g: %lld of %lld matches unfinished, its win rate is unreliable\n", points[p].setting, points[p].value,
+				tally.unfinished, tally.matches);
+			flagged++;
+		}
+	}
+	fclose(file);
+	printf("Wrote %s\n", outPath);
+	if (flagged > 0)
+	{
+		printf("%d values had more than %.0f%% of their matches unfinished\n", flagged, MAX_UNFINISHED_SHARE * 100);
+	}
+	return 0;
+}